@@ -0,0 +1,122 @@
+/**
+ * Checks Adafruit_BMP085::compensate()'s vector path (NEON on a Pi, SSE2
+ * on a PC) against its scalar one, which follows readTemperature() and
+ * readPressure() step for step.  Calibrations are spread around the
+ * datasheet's, raw temperatures cover all of 0..65535 (far from the
+ * calibration point the temperature division has quotients up to 2^26)
+ * and raw pressures every value of each mode.  Then both are timed.
+ *
+ *   ./compensateCheck [batches]
+ *
+ * Build it against the library as traceReplay.cpp is; it has its own
+ * main() and needs no sensor.  The exit status is 2 if any sample differs.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#define ARDUINO 100
+#include <Adafruit_BMP085.h>
+#undef ARDUINO
+
+#define BATCH 1024
+
+static uint16_t UT[BATCH];
+static uint32_t UP[BATCH];
+static int16_t  batchT[BATCH], scalarT[BATCH];
+static int32_t  batchP[BATCH], scalarP[BATCH];
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint32_t rnd(void)
+{
+	static uint32_t x = 2463534242UL;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+static int32_t around(int32_t value, int32_t spread)
+{
+	return value + (int32_t)(rnd() % (2 * spread + 1)) - spread;
+}
+
+// The driver divides by X1 + MD and by B4: samples that make either zero
+// have no result to compare
+static bool divisible(const BMP085_Calibration *c, int32_t ut)
+{
+	int32_t X1 = (ut - (int32_t)c->ac6) * ((int32_t)c->ac5) >> 15;
+	if (X1 + (int32_t)c->md == 0) {
+		return false;
+	}
+	int32_t B6 = X1 + ((int32_t)c->mc << 11) / (X1 + (int32_t)c->md) - 4000;
+	int32_t X3 = ((((int32_t)c->ac3 * B6) >> 13) +
+	              (((int32_t)c->b1 * ((B6 * B6) >> 12)) >> 16) + 2) >> 2;
+	return ((uint32_t)c->ac4 * (uint32_t)(X3 + 32768)) >> 15 != 0;
+}
+
+int main(int argc, char *argv[])
+{
+	long batches = argc > 1 ? atol(argv[1]) : 2000;
+	unsigned long samples = 0, differing = 0;
+	double batchTime = 0, scalarTime = 0;
+
+	for (long b = 0; b < batches; b++) {
+		BMP085_Calibration c;
+		uint8_t oss = b % 4;
+		c.ac1 = around(408, 4000);
+		c.ac2 = around(-72, 1200);
+		c.ac3 = around(-14383, 2000);
+		c.ac4 = around(32741, 2000);
+		c.ac5 = around(32757, 6000);
+		c.ac6 = around(23153, 2000);
+		c.b1  = around(6190, 300);
+		c.b2  = around(4, 50);
+		c.mb  = -32768;
+		c.mc  = around(-8711, 1500);
+		c.md  = around(2868, 1000);
+
+		uint32_t n = 0;
+		while (n < BATCH) {
+			UT[n] = rnd();
+			UP[n] = rnd() & ((1UL << (16 + oss)) - 1);
+			if (divisible(&c, UT[n])) {
+				n++;
+			}
+		}
+
+		double t = now();
+		Adafruit_BMP085::compensate(&c, oss, UT, UP, batchT, batchP, n);
+		batchTime += now() - t;
+		t = now();
+		for (uint32_t i = 0; i < n; i++) { // Below a vector's worth: scalar
+			Adafruit_BMP085::compensate(&c, oss, &UT[i], &UP[i], &scalarT[i],
+			                            &scalarP[i], 1);
+		}
+		scalarTime += now() - t;
+
+		for (uint32_t i = 0; i < n; i++) {
+			if (batchT[i] != scalarT[i] || batchP[i] != scalarP[i]) {
+				if (differing < 10) {
+					printf("mode %u UT %5u UP %6lu: %d %ld, scalar %d %ld\n", oss,
+					       UT[i], (unsigned long)UP[i], batchT[i], (long)batchP[i],
+					       scalarT[i], (long)scalarP[i]);
+				}
+				differing++;
+			}
+		}
+		samples += n;
+	}
+
+	printf("%lu samples, %lu differing; batch %.1f, scalar %.1f Msamples/s\n",
+	       samples, differing, samples / batchTime / 1e6,
+	       samples / scalarTime / 1e6);
+	return differing ? 2 : 0;
+}
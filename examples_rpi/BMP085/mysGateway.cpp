@@ -75,51 +75,35 @@
 #define ARDUINO 100
 // Include Arduino libraries here
 #include <Adafruit_BMP085.h>
+#include <Adafruit_BMP085_Trace.h>
 #undef ARDUINO
 
 // Adapted from MySensors/PressureSensor.ino
 // For more information visit: https://www.mysensors.org/build/pressure
 
-int sample(float pressure);
+// The forecast, shared with traceReplay.cpp
+#include "forecast.h"
+
+// Record the sensor's bus traffic, for replaying with traceReplay.cpp
+//#define BMP085_TRACE "/var/lib/mysensors/bmp085.trace"
 
 #define BARO_CHILD 0
 #define TEMP_CHILD 1
 
 const float ALTITUDE = 688; // <-- adapt this value to your own location's altitude.
 
-const char *weather[] = { "stable", "sunny", "cloudy", "unstable", "thunderstorm", "unknown" };
-enum FORECAST
-{
-	STABLE = 0,            // "Stable Weather Pattern"
-	SUNNY = 1,            // "Slowly rising Good Weather", "Clear/Sunny "
-	CLOUDY = 2,            // "Slowly falling L-Pressure ", "Cloudy/Rain "
-	UNSTABLE = 3,        // "Quickly rising H-Press",     "Not Stable"
-	THUNDERSTORM = 4,    // "Quickly falling L-Press",    "Thunderstorm"
-	UNKNOWN = 5            // "Unknown (More Time needed)
-};
-
 Adafruit_BMP085 bmp = Adafruit_BMP085();      // Digital Pressure Sensor 
 bool bmp085_enabled = false;
 
+#ifdef BMP085_TRACE
+Adafruit_BMP085_WireBus i2c;
+Adafruit_BMP085_Recorder recorder(i2c);
+#endif
+
 float lastPressure = -1;
 float lastTemp = -1;
 int lastForecast = -1;
 
-const int LAST_SAMPLES_COUNT = 5;
-float lastPressureSamples[LAST_SAMPLES_COUNT];
-
-// this CONVERSION_FACTOR is used to convert from Pa to kPa in forecast algorithm
-// get kPa/h be dividing hPa by 10 
-#define CONVERSION_FACTOR (1.0/10.0)
-
-int minuteCount = 0;
-bool firstRound = true;
-// average value is used in forecast algorithm.
-float pressureAvg;
-// average after 2 hours is used as reference value for the next iteration.
-float pressureAvg2;
-
-float dP_dt;
 bool metric;
 MyMessage tempMsg(TEMP_CHILD, V_TEMP);
 MyMessage pressureMsg(BARO_CHILD, V_PRESSURE);
@@ -128,6 +112,13 @@ MyMessage forecastMsg(BARO_CHILD, V_FORECAST);
 unsigned long timer = 0;
 
 void setup() {
+#ifdef BMP085_TRACE
+	if (recorder.open(BMP085_TRACE)) {
+		bmp.setBus(&recorder);
+	} else {
+		debug("Could not open %s, not recording\n", BMP085_TRACE);
+	}
+#endif
 	if (!bmp.begin()) {
 		debug("Could not find a valid BMP085 sensor, check wiring!");
 	} else {
@@ -152,8 +143,11 @@ void loop() {
 		if (millis() - timer > 60000UL) {
 			timer = millis();
 
-			float pressure = bmp.readSealevelPressure(ALTITUDE) / 100.0;
-			float temperature = bmp.readTemperature();
+			BMP085_Reading reading;
+			bmp.readAll(&reading, ALTITUDE);
+
+			float pressure = reading.sealevelPressure / 100.0;
+			float temperature = reading.temperature;
 
 			if (!metric) {
 				// Convert to fahrenheit
@@ -183,113 +177,3 @@ void loop() {
 		}
 	}
 }
-
-float getLastPressureSamplesAverage()
-{
-	float lastPressureSamplesAverage = 0;
-
-	for (int i = 0; i < LAST_SAMPLES_COUNT; i++) {
-		lastPressureSamplesAverage += lastPressureSamples[i];
-	}
-	lastPressureSamplesAverage /= LAST_SAMPLES_COUNT;
-
-	return lastPressureSamplesAverage;
-}
-
-// Algorithm found here
-// http://www.freescale.com/files/sensors/doc/app_note/AN3914.pdf
-// Pressure in hPa -->  forecast done by calculating kPa/h
-int sample(float pressure)
-{
-	// Calculate the average of the last n minutes.
-	int index = minuteCount % LAST_SAMPLES_COUNT;
-	lastPressureSamples[index] = pressure;
-
-	minuteCount++;
-	if (minuteCount > 185) {
-		minuteCount = 6;
-	}
-
-	if (minuteCount == 5) {
-		pressureAvg = getLastPressureSamplesAverage();
-	} else if (minuteCount == 35) {
-		float lastPressureAvg = getLastPressureSamplesAverage();
-		float change = (lastPressureAvg - pressureAvg) * CONVERSION_FACTOR;
-		if (firstRound) { // first time initial 3 hour
-			dP_dt = change * 2; // note this is for t = 0.5hour
-		} else {
-			dP_dt = change / 1.5; // divide by 1.5 as this is the difference in time from 0 value.
-		}
-	} else if (minuteCount == 65) {
-		float lastPressureAvg = getLastPressureSamplesAverage();
-		float change = (lastPressureAvg - pressureAvg) * CONVERSION_FACTOR;
-		if (firstRound) { //first time initial 3 hour
-			dP_dt = change; //note this is for t = 1 hour
-		} else {
-			dP_dt = change / 2; //divide by 2 as this is the difference in time from 0 value
-		}
-	} else if (minuteCount == 95) {
-		float lastPressureAvg = getLastPressureSamplesAverage();
-		float change = (lastPressureAvg - pressureAvg) * CONVERSION_FACTOR;
-		if (firstRound) { // first time initial 3 hour
-			dP_dt = change / 1.5; // note this is for t = 1.5 hour
-		} else {
-			dP_dt = change / 2.5; // divide by 2.5 as this is the difference in time from 0 value
-		}
-	} else if (minuteCount == 125) {
-		float lastPressureAvg = getLastPressureSamplesAverage();
-		pressureAvg2 = lastPressureAvg; // store for later use.
-		float change = (lastPressureAvg - pressureAvg) * CONVERSION_FACTOR;
-		if (firstRound) { // first time initial 3 hour
-			dP_dt = change / 2; // note this is for t = 2 hour
-		} else {
-			dP_dt = change / 3; // divide by 3 as this is the difference in time from 0 value
-		}
-	} else if (minuteCount == 155) {
-		float lastPressureAvg = getLastPressureSamplesAverage();
-		float change = (lastPressureAvg - pressureAvg) * CONVERSION_FACTOR;
-		if (firstRound) { // first time initial 3 hour
-			dP_dt = change / 2.5; // note this is for t = 2.5 hour
-		} else {
-			dP_dt = change / 3.5; // divide by 3.5 as this is the difference in time from 0 value
-		}
-	} else if (minuteCount == 185) {
-		float lastPressureAvg = getLastPressureSamplesAverage();
-		float change = (lastPressureAvg - pressureAvg) * CONVERSION_FACTOR;
-		if (firstRound) { // first time initial 3 hour
-			dP_dt = change / 3; // note this is for t = 3 hour
-		} else {
-			dP_dt = change / 4; // divide by 4 as this is the difference in time from 0 value
-		}
-		pressureAvg = pressureAvg2; // Equating the pressure at 0 to the pressure at 2 hour after 3 hours have past.
-		firstRound = false; // flag to let you know that this is on the past 3 hour mark. Initialized to 0 outside main loop.
-	}
-
-	int forecast = UNKNOWN;
-	if (minuteCount < 35 && firstRound) { //if time is less than 35 min on the first 3 hour interval.
-		forecast = UNKNOWN;
-	} else if (dP_dt < (-0.25))	{
-		forecast = THUNDERSTORM;
-	} else if (dP_dt > 0.25) {
-		forecast = UNSTABLE;
-	} else if ((dP_dt > (-0.25)) && (dP_dt < (-0.05))) {
-		forecast = CLOUDY;
-	} else if ((dP_dt > 0.05) && (dP_dt < 0.25)) {
-		forecast = SUNNY;
-	} else if ((dP_dt >(-0.05)) && (dP_dt < 0.05)) {
-		forecast = STABLE;
-	} else {
-		forecast = UNKNOWN;
-	}
-
-	// uncomment when debugging
-	//printf(F("Forecast at minute "));
-	//printf(minuteCount);
-	//printf(F(" dP/dt = "));
-	//printf(dP_dt);
-	//printf(F("kPa/h --> "));
-	//printf(weather[forecast]);
-	//printf("/n");
-
-	return forecast;
-}
@@ -0,0 +1,92 @@
+/**
+ * Replays a BMP085 trace, as recorded by mysGateway.cpp with BMP085_TRACE
+ * set, through the unmodified driver and the gateway's sampling loop and
+ * forecast.  No sensor or radio is needed, and a replay runs as fast as
+ * the code does: days of samples take seconds.  The readings and
+ * forecasts are the ones the gateway had, which makes the program a
+ * regression test of the driver and the forecast and a benchmark of the
+ * loop.
+ *
+ *   ./traceReplay bmp085.trace [altitude]
+ *
+ * Build it against the library as the gateway is, but as a program of its
+ * own; it has its own main().  Nothing of Arduino.h or Wire.h is called at
+ * run time: the replay keeps the time and answers the bus.  The exit
+ * status is 2 if the driver's transfers no longer match the trace.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#define ARDUINO 100
+#include <Adafruit_BMP085.h>
+#include <Adafruit_BMP085_Trace.h>
+#undef ARDUINO
+
+#include "forecast.h"
+
+float altitude = 688; // As in mysGateway.cpp
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	Adafruit_BMP085 bmp;
+	Adafruit_BMP085_Replay replay;
+	unsigned long timer = 0;
+	unsigned long samples = 0;
+	int lastForecast = -1;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s trace [altitude]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2) {
+		altitude = atof(argv[2]);
+	}
+	if (!replay.open(argv[1])) {
+		fprintf(stderr, "%s: not a BMP085 trace\n", argv[1]);
+		return 1;
+	}
+	bmp.setBus(&replay);
+
+	double start = now();
+	if (!bmp.begin()) {
+		fprintf(stderr, "%s: no BMP085 in the trace\n", argv[1]);
+		return 1;
+	}
+
+	// The gateway's loop(), on the replay's clock
+	while (!replay.done()) {
+		if (replay.millis() - timer > 60000UL) {
+			timer = replay.millis();
+
+			BMP085_Reading reading;
+			bmp.readAll(&reading, altitude);
+
+			float pressure = reading.sealevelPressure / 100.0;
+			int forecast = sample(pressure);
+			samples++;
+
+			if (forecast != lastForecast) {
+				printf("%8.2f h  %7.2f hPa  %5.1f *C  %s\n", timer / 3600000.0,
+				       pressure, reading.temperature, weather[forecast]);
+				lastForecast = forecast;
+			}
+		}
+		replay.idle();
+	}
+	double took = now() - start;
+
+	printf("%lu samples over %.1f h in %.3f s, %lu transfers, %lu mismatched\n",
+	       samples, replay.millis() / 3600000.0, took,
+	       (unsigned long)replay.getTransfers(),
+	       (unsigned long)replay.getMismatches());
+	return replay.getMismatches() ? 2 : 0;
+}
@@ -39,6 +39,17 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "Adafruit_GFX.h"
 #include "glcdfont.c"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define GFX_NEON
+#elif defined(__AVX__)
+ #include <immintrin.h>
+ #define GFX_AVX
+#elif defined(__SSE2__)
+ #include <emmintrin.h>
+ #define GFX_SSE2
+#endif
+
 // Many (but maybe not all) non-AVR board installs define macros
 // for compatibility with existing PROGMEM-reading AVR code.
 // Do our own checks and defines here for good measure...
@@ -82,6 +93,8 @@ Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h):
   wrap      = true;
   _cp437    = false;
   gfxFont   = NULL;
+  fontProvider = NULL;
+  pageFont  = NULL;
 }
 
 // Draw a circle outline
@@ -497,6 +510,7 @@ void Adafruit_GFX::write(uint8_t c) {
     } else if(c != '\r') {
       uint8_t first = pgm_read_byte(&gfxFont->first);
       if((c >= first) && (c <= (uint8_t)pgm_read_byte(&gfxFont->last))) {
+        if(fontProvider) fontProvider->loadMetrics(c);
         uint8_t   c2    = c - pgm_read_byte(&gfxFont->first);
         GFXglyph *glyph = &(((GFXglyph *)pgm_read_pointer(&gfxFont->glyph))[c2]);
         uint8_t   w     = pgm_read_byte(&glyph->width),
@@ -556,6 +570,7 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
     // newlines, returns, non-printable characters, etc.  Calling drawChar()
     // directly with 'bad' characters of font may cause mayhem!
 
+    if(fontProvider) fontProvider->load(c);
     c -= pgm_read_byte(&gfxFont->first);
     GFXglyph *glyph  = &(((GFXglyph *)pgm_read_pointer(&gfxFont->glyph))[c]);
     uint8_t  *bitmap = (uint8_t *)pgm_read_pointer(&gfxFont->bitmap);
@@ -574,6 +589,22 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
       yo16 = yo;
     }
 
+    if(pageFont) { // 'fontconvert -p': bit yy&7 of byte (yy/8)*w + xx
+      for(yy=0; yy<h; yy++) {
+        for(xx=0; xx<w; xx++) {
+          if(pgm_read_byte(&bitmap[bo + (yy / 8) * w + xx]) & (1 << (yy & 7))) {
+            if(size == 1) {
+              drawPixel(x+xo+xx, y+yo+yy, color);
+            } else {
+              fillRect(x+(xo+xx)*(int16_t)size, y+(yo+yy)*(int16_t)size,
+                size, size, color);
+            }
+          }
+        }
+      }
+      return;
+    }
+
     // Todo: Add character clipping here
 
     // NOTE: THERE IS NO 'BACKGROUND' COLOR OPTION ON CUSTOM FONTS.
@@ -647,6 +678,18 @@ uint8_t Adafruit_GFX::getRotation(void) const {
   return rotation;
 }
 
+const GFXfont *Adafruit_GFX::getFont(void) const {
+  return gfxFont;
+}
+
+GFXfontProvider *Adafruit_GFX::getFontProvider(void) const {
+  return fontProvider;
+}
+
+const GFXfont *Adafruit_GFX::getPageFont(void) const {
+  return pageFont;
+}
+
 void Adafruit_GFX::setRotation(uint8_t x) {
   rotation = (x & 3);
   switch(rotation) {
@@ -686,7 +729,21 @@ void Adafruit_GFX::setFont(const GFXfont *f) {
     // Move cursor pos up 6 pixels so it's at top-left of char.
     cursor_y -= 6;
   }
-  gfxFont = (GFXfont *)f;
+  gfxFont      = (GFXfont *)f;
+  fontProvider = NULL;
+  pageFont     = NULL;
+}
+
+void Adafruit_GFX::setPageFont(const GFXfont *f) {
+  setFont(f);
+  pageFont = f;
+}
+
+// Use a runtime font provider (e.g. GFXFreeTypeFont).  Glyphs are pulled
+// into the provider's cache as write()/drawChar() encounter them.
+void Adafruit_GFX::setFont(GFXfontProvider &p) {
+  setFont(p.getFont());
+  fontProvider = &p;
 }
 
 // Pass string and a cursor position, returns UL corner and W,H.
@@ -713,6 +770,7 @@ void Adafruit_GFX::getTextBounds(char *str, int16_t x, int16_t y,
       if(c != '\n') { // Not a newline
         if(c != '\r') { // Not a carriage return, is normal char
           if((c >= first) && (c <= last)) { // Char present in current font
+            if(fontProvider) fontProvider->loadMetrics(c);
             c    -= first;
             glyph = &(((GFXglyph *)pgm_read_pointer(&gfxFont->glyph))[c]);
             gw    = pgm_read_byte(&glyph->width);
@@ -803,6 +861,7 @@ void Adafruit_GFX::getTextBounds(const __FlashStringHelper *str,
       if(c != '\n') { // Not a newline
         if(c != '\r') { // Not a carriage return, is normal char
           if((c >= first) && (c <= last)) { // Char present in current font
+            if(fontProvider) fontProvider->loadMetrics(c);
             c    -= first;
             glyph = &(((GFXglyph *)pgm_read_pointer(&gfxFont->glyph))[c]);
             gw    = pgm_read_byte(&glyph->width);
@@ -961,6 +1020,86 @@ boolean Adafruit_GFX_Button::justReleased() { return (!currstate && laststate);
 // GFXcanvas16 requires 2 bytes per pixel (no scanline pad).
 // NOT EXTENSIVELY TESTED YET.  MAY CONTAIN WORST BUGS KNOWN TO HUMANKIND.
 
+// Clip a rectangle in rotated (user) coordinates to the canvas, then turn
+// it into the equivalent rectangle in unrotated buffer coordinates.
+// Returns false if nothing is left to draw.
+static boolean canvasRect(uint8_t rotation, int16_t WIDTH, int16_t HEIGHT,
+ int16_t width, int16_t height,
+ int16_t &x, int16_t &y, int16_t &w, int16_t &h) {
+  if((w <= 0) || (h <= 0)) return false;
+  if(x < 0) { w += x; x = 0; }
+  if(y < 0) { h += y; y = 0; }
+  if(x + w > width)  w = width  - x;
+  if(y + h > height) h = height - y;
+  if((w <= 0) || (h <= 0)) return false;
+
+  int16_t t;
+  switch(rotation) {
+   case 1:
+    t = x;
+    x = WIDTH  - y - h;
+    y = t;
+    t = w; w = h; h = t;
+    break;
+   case 2:
+    x = WIDTH  - x - w;
+    y = HEIGHT - y - h;
+    break;
+   case 3:
+    t = x;
+    x = y;
+    y = HEIGHT - t - w;
+    t = w; w = h; h = t;
+    break;
+  }
+  return true;
+}
+
+// Store 'n' copies of a 16-bit color, a full vector register at a time.
+// Unaligned stores are used throughout; they cost next to nothing on the
+// Pi's Cortex-A cores and on x86, and canvas rows are rarely aligned.
+static void fill16(uint16_t *dst, uint16_t color, uint32_t n) {
+#if defined(GFX_NEON)
+  uint16x8_t v = vdupq_n_u16(color);
+  for(; n >= 16; n -= 16, dst += 16) {
+    vst1q_u16(dst, v);
+    vst1q_u16(dst + 8, v);
+  }
+  if(n >= 8) {
+    vst1q_u16(dst, v);
+    dst += 8; n -= 8;
+  }
+#elif defined(GFX_AVX)
+  __m256i v = _mm256_set1_epi16(color);
+  for(; n >= 32; n -= 32, dst += 32) {
+    _mm256_storeu_si256((__m256i *)dst, v);
+    _mm256_storeu_si256((__m256i *)(dst + 16), v);
+  }
+  if(n >= 16) {
+    _mm256_storeu_si256((__m256i *)dst, v);
+    dst += 16; n -= 16;
+  }
+#elif defined(GFX_SSE2)
+  __m128i v = _mm_set1_epi16(color);
+  for(; n >= 16; n -= 16, dst += 16) {
+    _mm_storeu_si128((__m128i *)dst, v);
+    _mm_storeu_si128((__m128i *)(dst + 8), v);
+  }
+  if(n >= 8) {
+    _mm_storeu_si128((__m128i *)dst, v);
+    dst += 8; n -= 8;
+  }
+#else
+  // Pairs of pixels as one 32-bit store; memcpy() keeps it legal (no
+  // aliasing a uint16_t buffer) and compiles to a plain store where the
+  // CPU allows one
+  uint32_t v = ((uint32_t)color << 16) | color;
+  if(((uintptr_t)dst & 2) && n) { *dst++ = color; n--; }
+  for(; n >= 2; n -= 2, dst += 2) memcpy(dst, &v, sizeof(v));
+#endif
+  while(n--) *dst++ = color;
+}
+
 GFXcanvas1::GFXcanvas1(uint16_t w, uint16_t h) : Adafruit_GFX(w, h) {
   uint16_t bytes = ((w + 7) / 8) * h;
   if((buffer = (uint8_t *)malloc(bytes))) {
@@ -976,6 +1115,11 @@ uint8_t* GFXcanvas1::getBuffer(void) {
   return buffer;
 }
 
+GFXsurface GFXcanvas1::getSurface(void) {
+  GFXsurface s = { buffer, WIDTH, HEIGHT, GFX_LAYOUT_ROWS };
+  return s;
+}
+
 void GFXcanvas1::drawPixel(int16_t x, int16_t y, uint16_t color) {
   // Bitmask tables of 0x80>>X and ~(0x80>>X), because X>>Y is slow on AVR
   static const uint8_t PROGMEM
@@ -1016,8 +1160,66 @@ void GFXcanvas1::fillScreen(uint16_t color) {
   }
 }
 
+// All three fills come down to the same unrotated rectangle: a column of
+// identical row spans.  Each span is a masked first byte, whole bytes
+// (memset, which stores full machine words) and a masked last byte; the
+// masks are worked out once per rectangle, not per pixel.
+void GFXcanvas1::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+ uint16_t color) {
+  if(!buffer ||
+     !canvasRect(rotation, WIDTH, HEIGHT, _width, _height, x, y, w, h))
+    return;
+
+  uint16_t bytesPerRow = (WIDTH + 7) / 8;
+  uint8_t *ptr         = &buffer[(x / 8) + (int32_t)y * bytesPerRow];
+  int16_t  x1          = x + w - 1,          // Last column, inclusive
+           n           = (x1 / 8) - (x / 8); // Bytes after the first
+  uint8_t  first       = 0xFF >> (x & 7),
+           last        = 0xFF << (7 - (x1 & 7));
+
+  if(!n) first &= last; // Span within a single byte
+
+  if(color) {
+    if((first == 0xFF) && (last == 0xFF) && (n + 1 == bytesPerRow)) {
+      memset(ptr, 0xFF, (uint32_t)bytesPerRow * h); // Whole rows
+      return;
+    }
+    for(; h--; ptr += bytesPerRow) {
+      ptr[0] |= first;
+      if(n) {
+        memset(ptr + 1, 0xFF, n - 1);
+        ptr[n] |= last;
+      }
+    }
+  } else {
+    if((first == 0xFF) && (last == 0xFF) && (n + 1 == bytesPerRow)) {
+      memset(ptr, 0x00, (uint32_t)bytesPerRow * h);
+      return;
+    }
+    first = ~first;
+    last  = ~last;
+    for(; h--; ptr += bytesPerRow) {
+      ptr[0] &= first;
+      if(n) {
+        memset(ptr + 1, 0x00, n - 1);
+        ptr[n] &= last;
+      }
+    }
+  }
+}
+
+void GFXcanvas1::drawFastHLine(int16_t x, int16_t y, int16_t w,
+ uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void GFXcanvas1::drawFastVLine(int16_t x, int16_t y, int16_t h,
+ uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
 GFXcanvas16::GFXcanvas16(uint16_t w, uint16_t h) : Adafruit_GFX(w, h) {
-  uint16_t bytes = w * h * 2;
+  uint32_t bytes = (uint32_t)w * h * 2;
   if((buffer = (uint16_t *)malloc(bytes))) {
     memset(buffer, 0, bytes);
   }
@@ -1053,7 +1255,7 @@ void GFXcanvas16::drawPixel(int16_t x, int16_t y, uint16_t color) {
       break;
     }
 
-    buffer[x + y * WIDTH] = color;
+    buffer[x + (int32_t)y * WIDTH] = color;
   }
 }
 
@@ -1061,11 +1263,284 @@ void GFXcanvas16::fillScreen(uint16_t color) {
   if(buffer) {
     uint8_t hi = color >> 8, lo = color & 0xFF;
     if(hi == lo) {
-      memset(buffer, lo, WIDTH * HEIGHT * 2);
+      memset(buffer, lo, (uint32_t)WIDTH * HEIGHT * 2);
     } else {
-      uint16_t i, pixels = WIDTH * HEIGHT;
-      for(i=0; i<pixels; i++) buffer[i] = color;
+      fill16(buffer, color, (uint32_t)WIDTH * HEIGHT);
+    }
+  }
+}
+
+void GFXcanvas16::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+ uint16_t color) {
+  if(!buffer ||
+     !canvasRect(rotation, WIDTH, HEIGHT, _width, _height, x, y, w, h))
+    return;
+
+  uint16_t *ptr = &buffer[x + (int32_t)y * WIDTH];
+  if(w == WIDTH) {        // Full rows are contiguous, one run does it
+    fill16(ptr, color, (uint32_t)w * h);
+  } else if(w == 1) {     // Column: nothing to vectorize, just stride
+    while(h--) {
+      *ptr = color;
+      ptr += WIDTH;
     }
+  } else {
+    while(h--) {
+      fill16(ptr, color, w);
+      ptr += WIDTH;
+    }
+  }
+}
+
+void GFXcanvas16::drawFastHLine(int16_t x, int16_t y, int16_t w,
+ uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void GFXcanvas16::drawFastVLine(int16_t x, int16_t y, int16_t h,
+ uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+GFXcanvasPage::GFXcanvasPage(uint16_t w, uint16_t h) : Adafruit_GFX(w, h) {
+  uint32_t bytes = (uint32_t)w * ((h + 7) / 8);
+  if((buffer = (uint8_t *)malloc(bytes))) {
+    memset(buffer, 0, bytes);
   }
 }
 
+GFXcanvasPage::~GFXcanvasPage(void) {
+  if(buffer) free(buffer);
+}
+
+uint8_t* GFXcanvasPage::getBuffer(void) {
+  return buffer;
+}
+
+GFXsurface GFXcanvasPage::getSurface(void) {
+  GFXsurface s = { buffer, WIDTH, HEIGHT, GFX_LAYOUT_PAGES };
+  return s;
+}
+
+void GFXcanvasPage::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if(buffer) {
+    if((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return;
+
+    int16_t t;
+    switch(rotation) {
+     case 1:
+      t = x;
+      x = WIDTH  - 1 - y;
+      y = t;
+      break;
+     case 2:
+      x = WIDTH  - 1 - x;
+      y = HEIGHT - 1 - y;
+      break;
+     case 3:
+      t = x;
+      x = y;
+      y = HEIGHT - 1 - t;
+      break;
+    }
+
+    uint8_t *ptr = &buffer[x + (int32_t)(y / 8) * WIDTH];
+    if(color) *ptr |=  (1 << (y & 7));
+    else      *ptr &= ~(1 << (y & 7));
+  }
+}
+
+void GFXcanvasPage::fillScreen(uint16_t color) {
+  if(buffer) {
+    memset(buffer, color ? 0xFF : 0x00, (uint32_t)WIDTH * ((HEIGHT + 7) / 8));
+  }
+}
+
+// Work down the pages the rectangle touches; each is a run of w bytes
+// sharing one mask, and pages covered top to bottom are a plain memset.
+void GFXcanvasPage::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+ uint16_t color) {
+  if(!buffer ||
+     !canvasRect(rotation, WIDTH, HEIGHT, _width, _height, x, y, w, h))
+    return;
+
+  int16_t  y1  = y + h;  // One past the last row
+  uint8_t *ptr = &buffer[x + (int32_t)(y / 8) * WIDTH];
+  for(; y < y1; y = (y | 7) + 1, ptr += WIDTH) {
+    uint8_t mask = 0xFF << (y & 7);
+    if(y1 - (y & ~7) < 8) mask &= 0xFF >> (8 - (y1 & 7));
+    if(mask == 0xFF) {
+      memset(ptr, color ? 0xFF : 0x00, w);
+    } else if(color) {
+      for(int16_t i=0; i<w; i++) ptr[i] |= mask;
+    } else {
+      mask = ~mask;
+      for(int16_t i=0; i<w; i++) ptr[i] &= mask;
+    }
+  }
+}
+
+void GFXcanvasPage::drawFastHLine(int16_t x, int16_t y, int16_t w,
+ uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void GFXcanvasPage::drawFastVLine(int16_t x, int16_t y, int16_t h,
+ uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+// Row-major bytes have the leftmost pixel in bit 7, so after
+// gfxTranspose8x8() column x comes out in byte 7 - x; the mapping is its
+// own inverse and serves both conversions.
+void GFXcanvasPage::fromRowMajor(const uint8_t *src, uint8_t *dst,
+ uint16_t w, uint16_t h) {
+  uint16_t stride = (w + 7) / 8;
+  for(uint16_t y=0; y<h; y+=8, dst+=w) {
+    uint8_t rows = (h - y < 8) ? h - y : 8;
+    for(uint16_t bx=0; bx<stride; bx++) {
+      uint64_t m = 0;
+      for(uint8_t r=0; r<rows; r++) {
+        m |= (uint64_t)src[(uint32_t)(y + r) * stride + bx] << (r * 8);
+      }
+      m = gfxTranspose8x8(m);
+      uint8_t cols = (w - bx * 8 < 8) ? w - bx * 8 : 8;
+      for(uint8_t c=0; c<cols; c++) dst[bx * 8 + c] = m >> ((7 - c) * 8);
+    }
+  }
+}
+
+void GFXcanvasPage::toRowMajor(const uint8_t *src, uint8_t *dst,
+ uint16_t w, uint16_t h) {
+  uint16_t stride = (w + 7) / 8;
+  for(uint16_t y=0; y<h; y+=8, src+=w) {
+    uint8_t rows = (h - y < 8) ? h - y : 8;
+    for(uint16_t bx=0; bx<stride; bx++) {
+      uint64_t m = 0;
+      uint8_t  cols = (w - bx * 8 < 8) ? w - bx * 8 : 8;
+      for(uint8_t c=0; c<cols; c++) {
+        m |= (uint64_t)src[bx * 8 + c] << ((7 - c) * 8);
+      }
+      m = gfxTranspose8x8(m);
+      for(uint8_t r=0; r<rows; r++) {
+        dst[(uint32_t)(y + r) * stride + bx] = m >> (r * 8);
+      }
+    }
+  }
+}
+
+// -------------------------------------------------------------------------
+
+// GFXfontProvider keeps glyph bitmaps in 'nSlots' fixed-size slots of a
+// single arena, so a glyph's bitmapOffset is just slot * slotBytes and
+// drawChar() needs no knowledge of the cache.  Evicting picks the slot with
+// the oldest use stamp; that scan only runs on a miss, where rasterizing
+// the glyph costs far more anyway.
+
+GFXfontProvider::GFXfontProvider(void) {
+  memset(&font, 0, sizeof(font));
+  owner  = NULL;
+  stamp  = NULL;
+  nSlots = 0;
+  release();
+}
+
+GFXfontProvider::~GFXfontProvider(void) {
+  release();
+}
+
+const GFXfont *GFXfontProvider::getFont(void) const {
+  return &font;
+}
+
+uint32_t GFXfontProvider::getHits(void) const {
+  return hits;
+}
+
+uint32_t GFXfontProvider::getMisses(void) const {
+  return misses;
+}
+
+uint32_t GFXfontProvider::getEvictions(void) const {
+  return evictions;
+}
+
+void GFXfontProvider::resetStats(void) {
+  hits = misses = evictions = 0;
+}
+
+boolean GFXfontProvider::allocate(uint8_t first, uint8_t last,
+ uint8_t yAdvance, uint8_t slots, uint16_t bytes) {
+  release();
+  if((last < first) || !slots || !bytes ||
+     ((uint32_t)slots * bytes > 0xFFFF)) return false;
+
+  uint16_t n = last - first + 1;
+  if(!(font.glyph  = (GFXglyph *)calloc(n, sizeof(GFXglyph)))  ||
+     !(font.bitmap = (uint8_t  *)malloc((uint32_t)slots * bytes)) ||
+     !(owner       = (uint16_t *)malloc(slots * sizeof(uint16_t))) ||
+     !(stamp       = (uint32_t *)calloc(slots + 1, sizeof(uint32_t)))) {
+    release();
+    return false;
+  }
+  memset(owner, 0xFF, slots * sizeof(uint16_t));
+  font.first    = first;
+  font.last     = last;
+  font.yAdvance = yAdvance;
+  nSlots        = slots;
+  slotBytes     = bytes;
+  return true;
+}
+
+void GFXfontProvider::release(void) {
+  free(font.glyph);
+  free(font.bitmap);
+  free(owner);
+  free(stamp);
+  memset(&font, 0, sizeof(font));
+  memset(resident, 0, sizeof(resident));
+  memset(known, 0, sizeof(known));
+  owner  = NULL;
+  stamp  = NULL;
+  nSlots = 0;
+  slotBytes = 0;
+  tick   = 0;
+  resetStats();
+}
+
+void GFXfontProvider::miss(uint8_t i) {
+  if(!nSlots) return;
+  misses++;
+
+  // Free slot if there is one, else least recently used
+  uint8_t  s, slot = 0;
+  for(s=0; s<nSlots; s++) {
+    if(owner[s] == 0xFFFF) { slot = s; break; }
+    if(stamp[s] < stamp[slot]) slot = s;
+  }
+
+  // An empty bitmap writes no bytes, so the occupant survives until the
+  // glyph turns out to need the slot
+  GFXglyph *glyph = &font.glyph[i];
+  uint16_t  bo    = slot * slotBytes;
+  if(!rasterize(font.first + i, glyph, &font.bitmap[bo], slotBytes)) {
+    memset(glyph, 0, sizeof(GFXglyph));
+  }
+
+  if(glyph->width && glyph->height) {
+    if(owner[slot] != 0xFFFF) { // Evict previous occupant, keep its metrics
+      uint8_t old = owner[slot];
+      resident[old >> 3] &= ~(1 << (old & 7));
+      evictions++;
+    }
+    glyph->bitmapOffset = bo;
+    owner[slot]  = i;
+    slotOf[i]    = slot;
+    stamp[slot]  = ++tick;
+  } else {
+    glyph->bitmapOffset = 0;
+    slotOf[i]    = nSlots; // Nothing to draw; park on the dummy stamp
+  }
+  resident[i >> 3] |= 1 << (i & 7);
+  known[i >> 3]    |= 1 << (i & 7);
+}
@@ -9,6 +9,9 @@
 #endif
 
 #include "gfxfont.h"
+#include "GFXblit.h"
+
+class GFXfontProvider;
 
 class Adafruit_GFX : public Print {
 
@@ -28,16 +31,12 @@ class Adafruit_GFX : public Print {
     drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
     fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
     fillScreen(uint16_t color),
-    invertDisplay(boolean i);
-
-  // These exist only with Adafruit_GFX (no subclass overrides)
-  void
+    invertDisplay(boolean i),
+    drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+      uint16_t bg, uint8_t size),
+    setRotation(uint8_t r),
     drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color),
-    drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername,
-      uint16_t color),
     fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color),
-    fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername,
-      int16_t delta, uint16_t color),
     drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
       int16_t x2, int16_t y2, uint16_t color),
     fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
@@ -55,17 +54,23 @@ class Adafruit_GFX : public Print {
     drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
       int16_t w, int16_t h, uint16_t color, uint16_t bg),
     drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
-      int16_t w, int16_t h, uint16_t color),
-    drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
-      uint16_t bg, uint8_t size),
+      int16_t w, int16_t h, uint16_t color);
+
+  // These exist only with Adafruit_GFX (no subclass overrides)
+  void
+    drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername,
+      uint16_t color),
+    fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername,
+      int16_t delta, uint16_t color),
     setCursor(int16_t x, int16_t y),
     setTextColor(uint16_t c),
     setTextColor(uint16_t c, uint16_t bg),
     setTextSize(uint8_t s),
     setTextWrap(boolean w),
-    setRotation(uint8_t r),
     cp437(boolean x=true),
     setFont(const GFXfont *f = NULL),
+    setFont(GFXfontProvider &p),
+    setPageFont(const GFXfont *f),
     getTextBounds(char *string, int16_t x, int16_t y,
       int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h),
     getTextBounds(const __FlashStringHelper *s, int16_t x, int16_t y,
@@ -82,6 +87,15 @@ class Adafruit_GFX : public Print {
 
   uint8_t getRotation(void) const;
 
+  // Font as last set (NULL = classic), and its provider if it has one.
+  // getPageFont() is the font if it was set with setPageFont(): made by
+  // 'fontconvert -p', with glyphs in page layout (a byte per column per 8
+  // rows, LSB on top) rather than row-major.  Any target draws those;
+  // page-layout displays such as the SSD1306 draw them a byte at a time.
+  const GFXfont   *getFont(void) const;
+  GFXfontProvider *getFontProvider(void) const;
+  const GFXfont   *getPageFont(void) const;
+
   // get current cursor position (get rotation safe maximum values, using: width() for x, height() for y)
   int16_t getCursorX(void) const;
   int16_t getCursorY(void) const;
@@ -102,6 +116,84 @@ class Adafruit_GFX : public Print {
     _cp437; // If set, use correct CP437 charset (default is off)
   GFXfont
     *gfxFont;
+  GFXfontProvider
+    *fontProvider; // Non-NULL if gfxFont is filled in on demand
+  const GFXfont
+    *pageFont;     // gfxFont if its glyphs are in page layout, else NULL
+};
+
+// Base class for fonts whose glyphs are produced at runtime rather than
+// compiled in (see GFXFreeTypeFont).  The provider owns an ordinary
+// GFXfont -- full glyph table plus a bitmap arena of fixed-size slots --
+// so drawChar() renders it exactly like a fontconvert table.  Glyph
+// bitmaps are created on first use and kept in a bounded LRU cache;
+// metrics are kept for every glyph ever loaded, so getTextBounds() never
+// forces a bitmap back in.  The hit path is a bit test and a timestamp
+// store, inlined ahead of each drawChar().
+
+class GFXfontProvider {
+
+ public:
+  GFXfontProvider(void);
+  virtual ~GFXfontProvider(void);
+
+  const GFXfont *getFont(void) const;
+  uint32_t
+    getHits(void) const,
+    getMisses(void) const,
+    getEvictions(void) const;
+  void
+    resetStats(void);
+
+  // Make glyph bitmap for char 'c' resident (c must be in first..last)
+  inline void load(uint8_t c) {
+    uint8_t i = c - font.first;
+    if(resident[i >> 3] & (1 << (i & 7))) {
+      stamp[slotOf[i]] = ++tick;
+      hits++;
+    } else {
+      miss(i);
+    }
+  }
+  // Make metrics for char 'c' valid; bitmap may or may not be resident
+  inline void loadMetrics(uint8_t c) {
+    uint8_t i = c - font.first;
+    if(!(known[i >> 3] & (1 << (i & 7)))) miss(i);
+  }
+
+ protected:
+  boolean allocate(uint8_t first, uint8_t last, uint8_t yAdvance,
+    uint8_t slots, uint16_t slotBytes);
+  void release(void);
+
+  // Render char 'c' into 'dst' as a fontconvert-style bit-packed bitmap
+  // of at most 'maxBytes' bytes and fill in the glyph metrics (the
+  // bitmapOffset field is managed by the caller).  Write no more than
+  // the (width * height + 7) / 8 bytes the metrics call for -- nothing
+  // at all for an empty glyph, whose 'dst' still belongs to another.
+  // Return false, having written nothing, if the glyph doesn't exist;
+  // it is then treated as an empty glyph.
+  virtual boolean rasterize(uint8_t c, GFXglyph *glyph, uint8_t *dst,
+    uint16_t maxBytes) = 0;
+
+  GFXfont
+    font;
+
+ private:
+  void miss(uint8_t i);
+
+  uint8_t
+    resident[32],  // Bitmap is in the arena, one bit per glyph
+    known[32],     // Metrics are valid, one bit per glyph
+    slotOf[256],   // Arena slot holding each resident glyph
+    nSlots;
+  uint16_t
+    slotBytes,
+    *owner;        // Glyph index held by each slot, 0xFFFF = free
+  uint32_t
+    *stamp,        // Last-use tick per slot (+1 dummy for empty glyphs)
+    tick,
+    hits, misses, evictions;
 };
 
 class Adafruit_GFX_Button {
@@ -136,20 +228,58 @@ class GFXcanvas1 : public Adafruit_GFX {
   GFXcanvas1(uint16_t w, uint16_t h);
   ~GFXcanvas1(void);
   void     drawPixel(int16_t x, int16_t y, uint16_t color),
+           drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color),
+           drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color),
+           fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+             uint16_t color),
            fillScreen(uint16_t color);
   uint8_t *getBuffer(void);
+  GFXsurface getSurface(void);
  private:
   uint8_t *buffer;
 };
 
 class GFXcanvas16 : public Adafruit_GFX {
+
+ public:
   GFXcanvas16(uint16_t w, uint16_t h);
   ~GFXcanvas16(void);
   void      drawPixel(int16_t x, int16_t y, uint16_t color),
+            drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color),
+            drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color),
+            fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+              uint16_t color),
             fillScreen(uint16_t color);
   uint16_t *getBuffer(void);
  private:
   uint16_t *buffer;
 };
 
+// 1-bit canvas in the SSD1306 frame buffer layout: each byte is a vertical
+// run of 8 pixels (LSB on top) and byte x of page p holds rows 8p..8p+7 of
+// column x.  Pages can be copied straight into the display buffer.
+class GFXcanvasPage : public Adafruit_GFX {
+
+ public:
+  GFXcanvasPage(uint16_t w, uint16_t h);
+  ~GFXcanvasPage(void);
+  void     drawPixel(int16_t x, int16_t y, uint16_t color),
+           drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color),
+           drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color),
+           fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+             uint16_t color),
+           fillScreen(uint16_t color);
+  uint8_t *getBuffer(void);
+  GFXsurface getSurface(void);
+
+  // Convert a w x h bitmap between GFXcanvas1 (row-major, MSB left, rows
+  // padded to a byte) and page layout, 8x8 pixels per step
+  static void fromRowMajor(const uint8_t *src, uint8_t *dst,
+                uint16_t w, uint16_t h),
+              toRowMajor(const uint8_t *src, uint8_t *dst,
+                uint16_t w, uint16_t h);
+ private:
+  uint8_t *buffer;
+};
+
 #endif // _ADAFRUIT_GFX_H
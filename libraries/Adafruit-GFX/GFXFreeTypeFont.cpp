@@ -0,0 +1,113 @@
+/*
+Runtime counterpart of fontconvert: rasterizes TrueType glyphs on demand
+into a GFXfontProvider cache.  See GFXFreeTypeFont.h for usage.
+*/
+
+#if defined(__has_include)
+ #if __has_include(<ft2build.h>)
+  #define GFX_HAVE_FREETYPE
+ #endif
+#endif
+
+#ifdef GFX_HAVE_FREETYPE
+
+#include "GFXFreeTypeFont.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+GFXFreeTypeFont::GFXFreeTypeFont(void) {
+  library = NULL;
+  face    = NULL;
+}
+
+GFXFreeTypeFont::~GFXFreeTypeFont(void) {
+  end();
+}
+
+boolean GFXFreeTypeFont::begin(const char *filename, uint8_t size,
+ uint16_t dpi, uint8_t cacheGlyphs, uint8_t first, uint8_t last) {
+  FT_Library lib;
+  FT_Face    f;
+
+  end();
+  if(FT_Init_FreeType(&lib)) return false;
+  if(FT_New_Face(lib, filename, 0, &f)) {
+    FT_Done_FreeType(lib);
+    return false;
+  }
+  library = lib;
+  face    = f;
+
+  // << 6 because '26dot6' fixed-point format
+  FT_Set_Char_Size(f, size << 6, 0, dpi, 0);
+
+  // Every slot must hold the largest glyph, i.e. the scaled font bounding
+  // box (+1 pixel each way for hinting round-off).  Anything that still
+  // doesn't fit is cropped at the bottom by rasterize().
+  uint32_t w = (FT_MulFix(f->bbox.xMax - f->bbox.xMin,
+                 f->size->metrics.x_scale) >> 6) + 2,
+           h = (FT_MulFix(f->bbox.yMax - f->bbox.yMin,
+                 f->size->metrics.y_scale) >> 6) + 2,
+           bytes = (w * h + 7) / 8;
+  if(bytes > 0xFFFF) bytes = 0xFFFF;
+  if((uint32_t)cacheGlyphs * bytes > 0xFFFF) { // 16-bit bitmapOffset
+    cacheGlyphs = 0xFFFF / bytes;
+  }
+
+  if(!allocate(first, last, f->size->metrics.height >> 6, cacheGlyphs,
+     bytes)) {
+    end();
+    return false;
+  }
+  return true;
+}
+
+void GFXFreeTypeFont::end(void) {
+  release();
+  if(face)    FT_Done_Face((FT_Face)face);
+  if(library) FT_Done_FreeType((FT_Library)library);
+  face    = NULL;
+  library = NULL;
+}
+
+boolean GFXFreeTypeFont::rasterize(uint8_t c, GFXglyph *glyph,
+ uint8_t *dst, uint16_t maxBytes) {
+  FT_Face f = (FT_Face)face;
+
+  // MONO renderer provides clean image with perfect crop, as in fontconvert
+  if(!f || FT_Load_Char(f, c, FT_LOAD_RENDER | FT_LOAD_TARGET_MONO))
+    return false;
+
+  FT_GlyphSlot slot   = f->glyph;
+  FT_Bitmap   *bitmap = &slot->bitmap;
+  if(bitmap->pixel_mode != FT_PIXEL_MODE_MONO) return false;
+
+  uint16_t w = bitmap->width, h = bitmap->rows;
+  if(w > 255) w = 255;
+  if(w && ((uint32_t)w * h > (uint32_t)maxBytes * 8)) h = maxBytes * 8 / w;
+
+  glyph->width    = w;
+  glyph->height   = h;
+  glyph->xAdvance = slot->advance.x >> 6;
+  glyph->xOffset  = slot->bitmap_left;
+  glyph->yOffset  = 1 - slot->bitmap_top;
+
+  // Bit-pack rows end to end, no per-scanline pad (as fontconvert enbit())
+  uint8_t  sum = 0, bit = 0x80;
+  for(uint16_t y=0; y<h; y++) {
+    const uint8_t *row = bitmap->buffer + y * bitmap->pitch;
+    for(uint16_t x=0; x<w; x++) {
+      if(row[x >> 3] & (0x80 >> (x & 7))) sum |= bit;
+      if(!(bit >>= 1)) {
+        *dst++ = sum;
+        sum    = 0;
+        bit    = 0x80;
+      }
+    }
+  }
+  if(bit != 0x80) *dst = sum;
+
+  return true;
+}
+
+#endif // GFX_HAVE_FREETYPE
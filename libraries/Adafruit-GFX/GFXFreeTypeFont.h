@@ -0,0 +1,39 @@
+#ifndef _GFXFREETYPEFONT_H_
+#define _GFXFREETYPEFONT_H_
+
+#include "Adafruit_GFX.h"
+
+// Runtime TrueType font for Linux hosts (Raspberry Pi etc.) with the
+// FreeType library installed.  Glyphs are rasterized with the same
+// settings as fontconvert (monochrome hinting, 141 DPI by default), so
+// a GFXFreeTypeFont at a given size matches the corresponding Fonts/*.h
+// table, but any size is available without regenerating headers:
+//
+//   GFXFreeTypeFont sans;
+//   sans.begin("/usr/share/fonts/truetype/freefont/FreeSans.ttf", 11);
+//   display.setFont(sans);
+//
+// Build with the FreeType include path and library, e.g.
+// -I/usr/include/freetype2 -lfreetype.  Without them this class is
+// declared but not compiled in.
+
+class GFXFreeTypeFont : public GFXfontProvider {
+
+ public:
+  GFXFreeTypeFont(void);
+  ~GFXFreeTypeFont(void);
+
+  boolean begin(const char *filename, uint8_t size, uint16_t dpi = 141,
+    uint8_t cacheGlyphs = 64, uint8_t first = ' ', uint8_t last = '~');
+  void    end(void);
+
+ protected:
+  boolean rasterize(uint8_t c, GFXglyph *glyph, uint8_t *dst,
+    uint16_t maxBytes);
+
+ private:
+  void *library, *face; // FT_Library and FT_Face; opaque to keep the
+                        // FreeType headers out of sketches
+};
+
+#endif // _GFXFREETYPEFONT_H_
@@ -0,0 +1,305 @@
+/*
+Raster-op compositing for 1-bit surfaces.  See GFXblit.h for usage.
+
+Both layouts reduce to the same inner step.  For each destination row
+(row layout) or page (page layout) the source bits are first shifted into
+line with the destination bytes, then a single combine pass applies the
+raster op under a byte mask that holds the clip edges and any stencil.
+The combine pass has no shifts left in it and runs a vector register or
+64-bit word at a time.
+*/
+
+#include "Adafruit_GFX.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define GFX_NEON
+#elif defined(__SSE2__)
+ #include <emmintrin.h>
+ #define GFX_SSE2
+#endif
+
+#define GFX_LANES(b) ((uint64_t)(b) * 0x0101010101010101ULL)
+
+// Every raster op can be written d ^ ((d & A) ^ (s & B) ^ (d & s & C))
+// with each term either all zeros or all ones, so one loop serves them
+// all and a mask m applies as d ^ (m & (...)).
+static const uint8_t ropTerms[][3] = {
+  //  A     B     C
+  { 0xFF, 0xFF, 0x00 }, // COPY:   d ^ d ^ s         = s
+  { 0x00, 0xFF, 0xFF }, // OR:     d ^ s ^ (d & s)   = d | s
+  { 0xFF, 0x00, 0xFF }, // AND:    d ^ d ^ (d & s)   = d & s
+  { 0x00, 0xFF, 0x00 }, // XOR:    d ^ s
+  { 0x00, 0x00, 0xFF }, // ANDNOT: d ^ (d & s)       = d & ~s
+};
+
+static void combine(uint8_t *d, const uint8_t *s, const uint8_t *m,
+ uint16_t n, const uint8_t *terms) {
+  uint16_t i = 0;
+#if defined(GFX_NEON)
+  uint8x16_t a = vdupq_n_u8(terms[0]), b = vdupq_n_u8(terms[1]),
+             c = vdupq_n_u8(terms[2]);
+  for(; i + 16 <= n; i += 16) {
+    uint8x16_t dv = vld1q_u8(d + i), sv = vld1q_u8(s + i),
+               t  = veorq_u8(veorq_u8(vandq_u8(dv, a), vandq_u8(sv, b)),
+                             vandq_u8(vandq_u8(dv, sv), c));
+    vst1q_u8(d + i, veorq_u8(dv, vandq_u8(vld1q_u8(m + i), t)));
+  }
+#elif defined(GFX_SSE2)
+  __m128i a = _mm_set1_epi8(terms[0]), b = _mm_set1_epi8(terms[1]),
+          c = _mm_set1_epi8(terms[2]);
+  for(; i + 16 <= n; i += 16) {
+    __m128i dv = _mm_loadu_si128((const __m128i *)(d + i)),
+            sv = _mm_loadu_si128((const __m128i *)(s + i)),
+            t  = _mm_xor_si128(_mm_xor_si128(_mm_and_si128(dv, a),
+                   _mm_and_si128(sv, b)),
+                   _mm_and_si128(_mm_and_si128(dv, sv), c));
+    _mm_storeu_si128((__m128i *)(d + i), _mm_xor_si128(dv, _mm_and_si128(
+      _mm_loadu_si128((const __m128i *)(m + i)), t)));
+  }
+#endif
+  uint64_t a64 = GFX_LANES(terms[0]), b64 = GFX_LANES(terms[1]),
+           c64 = GFX_LANES(terms[2]);
+  for(; i + 8 <= n; i += 8) {
+    uint64_t dw, sw, mw;
+    memcpy(&dw, d + i, 8);
+    memcpy(&sw, s + i, 8);
+    memcpy(&mw, m + i, 8);
+    dw ^= mw & ((dw & a64) ^ (sw & b64) ^ (dw & sw & c64));
+    memcpy(d + i, &dw, 8);
+  }
+  for(; i < n; i++) {
+    d[i] ^= m[i] & ((d[i] & terms[0]) ^ (s[i] & terms[1]) ^
+                    (d[i] & s[i] & terms[2]));
+  }
+}
+
+// Row layout: out[k] = the 8 bits of 'row' starting 'base' bits in (base
+// may be slightly negative), MSB first.  Bits outside the row read as 0.
+static void shiftBits(uint8_t *out, const uint8_t *row, int16_t stride,
+ int16_t base, uint16_t n) {
+  int16_t  q = (base + 8) / 8 - 1, // floor(base / 8) for base >= -8
+           a = base - q * 8;
+  uint16_t k = 0;
+  for(; (k < n) && (q + (int16_t)k < 0); k++) {
+    out[k] = a ? (row[0] >> (8 - a)) : 0;
+  }
+  if(a) {
+    for(; (k + 8 <= n) && (q + k + 9 <= stride); k += 8) {
+      const uint8_t *p = &row[q + k];
+      uint64_t v = ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+                   ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+                   ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+                   ((uint64_t)p[6] <<  8) |  (uint64_t)p[7];
+      v = (v << a) | (p[8] >> (8 - a));
+      for(uint8_t i=0; i<8; i++) out[k + i] = v >> (56 - i * 8);
+    }
+  } else if(q + (int16_t)n <= stride) {
+    memcpy(&out[k], &row[q + k], n - k);
+    return;
+  }
+  for(; k < n; k++) {
+    int16_t i = q + k;
+    uint8_t v = (i < stride) ? row[i] << a : 0;
+    if(a && (i + 1 < stride)) v |= row[i + 1] >> (8 - a);
+    out[k] = v;
+  }
+}
+
+// Page layout: each output byte is the source column's byte pair lo/hi
+// shifted down by 'sh' rows (either page may be missing, reading as 0).
+// The shift is applied to 8 columns at once with per-lane masks.
+static void shiftPages(uint8_t *out, const uint8_t *lo, const uint8_t *hi,
+ uint8_t sh, uint16_t n) {
+  uint16_t i = 0;
+  if(!sh) {
+    if(lo) memcpy(out, lo, n);
+    else   memset(out, 0, n);
+    return;
+  }
+  uint64_t loMask = GFX_LANES(0xFF >> sh),
+           hiMask = GFX_LANES((uint8_t)(0xFF << (8 - sh)));
+  for(; i + 8 <= n; i += 8) {
+    uint64_t l = 0, h = 0;
+    if(lo) memcpy(&l, lo + i, 8);
+    if(hi) memcpy(&h, hi + i, 8);
+    l = ((l >> sh) & loMask) | ((h << (8 - sh)) & hiMask);
+    memcpy(out + i, &l, 8);
+  }
+  for(; i < n; i++) {
+    out[i] = (lo ? lo[i] >> sh : 0) | (hi ? hi[i] << (8 - sh) : 0);
+  }
+}
+
+// Same-layout blit of an already clipped rectangle.  'scratch' holds
+// 2 * (w + 16) bytes.
+static void blitRows(const GFXsurface &dst, int16_t dx, int16_t dy,
+ const GFXsurface &src, int16_t sx, int16_t sy, int16_t w, int16_t h,
+ const uint8_t *terms, const GFXsurface *mask, uint8_t *scratch) {
+  int16_t  dStride = (dst.width + 7) / 8, sStride = (src.width + 7) / 8,
+           base    = sx - (dx & 7);
+  uint16_t n       = (dx + w - 1) / 8 - dx / 8 + 1;
+  uint8_t  first   = 0xFF >> (dx & 7),
+           last    = 0xFF << (7 - ((dx + w - 1) & 7)),
+          *bits    = scratch, *m = scratch + w + 16;
+
+  if(!mask) {
+    memset(m, 0xFF, n);
+    m[0]     &= first;
+    m[n - 1] &= last;
+  }
+  for(int16_t j=0; j<h; j++) {
+    int32_t row = (int32_t)(sy + j) * sStride;
+    shiftBits(bits, &src.buffer[row], sStride, base, n);
+    if(mask) {
+      shiftBits(m, &mask->buffer[row], sStride, base, n);
+      m[0]     &= first;
+      m[n - 1] &= last;
+    }
+    combine(&dst.buffer[(int32_t)(dy + j) * dStride + dx / 8], bits, m, n,
+      terms);
+  }
+}
+
+static void blitPages(const GFXsurface &dst, int16_t dx, int16_t dy,
+ const GFXsurface &src, int16_t sx, int16_t sy, int16_t w, int16_t h,
+ const uint8_t *terms, const GFXsurface *mask, uint8_t *scratch) {
+  int16_t  pages = (src.height + 7) / 8;
+  uint8_t *bits  = scratch, *m = scratch + w + 16;
+
+  for(int16_t row = dy & ~7; row < dy + h; row += 8) {
+    // Destination rows of this page inside the rectangle
+    uint8_t rows = 0xFF;
+    if(dy > row)         rows &= 0xFF << (dy - row);
+    if(dy + h < row + 8) rows &= 0xFF >> (row + 8 - (dy + h));
+
+    // Source row at the top of this page: page sp, shifted down sh rows
+    int16_t  off = row - dy + sy,
+             sp  = (off + 8) / 8 - 1;
+    uint8_t  sh  = off - sp * 8;
+    int32_t  lo  = (int32_t)sp * src.width + sx,
+             hi  = lo + src.width;
+    boolean  hasLo = (sp >= 0), hasHi = (sp + 1 < pages);
+
+    shiftPages(bits, hasLo ? &src.buffer[lo] : NULL,
+      hasHi ? &src.buffer[hi] : NULL, sh, w);
+    if(mask) {
+      shiftPages(m, hasLo ? &mask->buffer[lo] : NULL,
+        hasHi ? &mask->buffer[hi] : NULL, sh, w);
+      for(int16_t i=0; i<w; i++) m[i] &= rows;
+    } else {
+      memset(m, rows, w);
+    }
+    combine(&dst.buffer[(int32_t)(row / 8) * dst.width + dx], bits, m, w,
+      terms);
+  }
+}
+
+// Convert the w x h rectangle at (sx, sy) of 'src' into a new buffer of
+// the other layout, 8x8 blocks at a time.  Returns NULL if out of memory.
+static uint8_t *convertRect(const GFXsurface &src, int16_t sx, int16_t sy,
+ int16_t w, int16_t h, uint8_t *scratch) {
+  uint32_t rowBytes  = (uint32_t)((w + 7) / 8) * h,
+           pageBytes = (uint32_t)w * ((h + 7) / 8);
+  uint8_t *tmp = (uint8_t *)malloc(src.layout == GFX_LAYOUT_ROWS ?
+                   rowBytes : pageBytes),
+          *out = (uint8_t *)malloc(src.layout == GFX_LAYOUT_ROWS ?
+                   pageBytes : rowBytes);
+  if(tmp && out) {
+    // Copy the rectangle to the origin of a tight buffer, then convert
+    GFXsurface t = { tmp, w, h, src.layout };
+    if(src.layout == GFX_LAYOUT_ROWS) {
+      memset(tmp, 0, rowBytes);
+      blitRows(t, 0, 0, src, sx, sy, w, h, ropTerms[GFX_ROP_COPY], NULL,
+        scratch);
+      GFXcanvasPage::fromRowMajor(tmp, out, w, h);
+    } else {
+      memset(tmp, 0, pageBytes);
+      blitPages(t, 0, 0, src, sx, sy, w, h, ropTerms[GFX_ROP_COPY], NULL,
+        scratch);
+      GFXcanvasPage::toRowMajor(tmp, out, w, h);
+    }
+  } else if(out) {
+    free(out);
+    out = NULL;
+  }
+  if(tmp) free(tmp);
+  return out;
+}
+
+// One clipped strip of at most GFX_BLIT_SPAN columns
+static boolean blitStrip(const GFXsurface &dst, int16_t dx, int16_t dy,
+ const GFXsurface &src, int16_t sx, int16_t sy, int16_t w, int16_t h,
+ uint8_t rop, const GFXsurface *mask, uint8_t *scratch) {
+  GFXsurface        s = src, m = src;
+  const GFXsurface *mp = mask;
+  uint8_t   *conv = NULL, *convMask = NULL;
+  boolean    ok = true;
+
+  if(src.layout != dst.layout) {
+    // Bring the source (and stencil) over to the destination's layout
+    conv = convertRect(src, sx, sy, w, h, scratch);
+    if(mask) convMask = convertRect(*mask, sx, sy, w, h, scratch);
+    if(!conv || (mask && !convMask)) {
+      ok = false;
+    } else {
+      GFXsurface c = { conv, w, h, dst.layout };
+      s  = c;
+      sx = sy = 0;
+      if(mask) {
+        m  = c;
+        m.buffer = convMask;
+        mp = &m;
+      }
+    }
+  }
+
+  if(ok) {
+    if(dst.layout == GFX_LAYOUT_ROWS) {
+      blitRows(dst, dx, dy, s, sx, sy, w, h, ropTerms[rop], mp, scratch);
+    } else {
+      blitPages(dst, dx, dy, s, sx, sy, w, h, ropTerms[rop], mp, scratch);
+    }
+  }
+
+  if(conv)     free(conv);
+  if(convMask) free(convMask);
+  return ok;
+}
+
+boolean gfxBlit(const GFXsurface &dst, int16_t dx, int16_t dy,
+ const GFXsurface &src, int16_t sx, int16_t sy, int16_t w, int16_t h,
+ uint8_t rop, const GFXsurface *mask) {
+  if(!dst.buffer || !src.buffer || (rop > GFX_ROP_ANDNOT) ||
+     (dst.layout > GFX_LAYOUT_PAGES) || (src.layout > GFX_LAYOUT_PAGES))
+    return false;
+  if(mask && (!mask->buffer || (mask->layout != src.layout) ||
+     (mask->width != src.width) || (mask->height != src.height)))
+    return false;
+
+  // Clip to the source, then to the destination
+  if(sx < 0) { dx -= sx; w += sx; sx = 0; }
+  if(sy < 0) { dy -= sy; h += sy; sy = 0; }
+  if(sx + w > src.width)  w = src.width  - sx;
+  if(sy + h > src.height) h = src.height - sy;
+  if(dx < 0) { sx -= dx; w += dx; dx = 0; }
+  if(dy < 0) { sy -= dy; h += dy; dy = 0; }
+  if(dx + w > dst.width)  w = dst.width  - dx;
+  if(dy + h > dst.height) h = dst.height - dy;
+  if((w <= 0) || (h <= 0)) return true;
+
+  // Pixels are independent, so strips side by side add up to the whole
+  uint8_t scratch[2 * (GFX_BLIT_SPAN + 16)];
+  for(int16_t x=0; x<w; x+=GFX_BLIT_SPAN) {
+    int16_t n = (w - x < GFX_BLIT_SPAN) ? w - x : GFX_BLIT_SPAN;
+    if(!blitStrip(dst, dx + x, dy, src, sx + x, sy, n, h, rop, mask,
+         scratch))
+      return false;
+  }
+  return true;
+}
+
+boolean gfxBlit(const GFXsurface &dst, int16_t dx, int16_t dy,
+ const GFXsurface &src, uint8_t rop, const GFXsurface *mask) {
+  return gfxBlit(dst, dx, dy, src, 0, 0, src.width, src.height, rop, mask);
+}
@@ -0,0 +1,64 @@
+// Raster-op compositing between 1-bit surfaces: GFXcanvas1, GFXcanvasPage
+// and the SSD1306 frame buffer, any combination.  Get a descriptor from the
+// object's getSurface() and call gfxBlit():
+//
+//   GFXsurface screen = display.getSurface(), stencil = alertMask.getSurface();
+//   gfxBlit(screen, 0, 0, background.getSurface());
+//   gfxBlit(screen, 90, 0, alert.getSurface(), 0, 0, 38, 16,
+//     GFX_ROP_XOR, &stencil);
+//
+// Coordinates are in each buffer's own unrotated pixel space (setRotation()
+// affects drawing, not the stored layout).  Rectangles are clipped against
+// both source and destination.
+
+#ifndef _GFXBLIT_H_
+#define _GFXBLIT_H_
+
+// Buffer layouts
+#define GFX_LAYOUT_ROWS  0 // Row-major, MSB leftmost, rows padded to a byte
+#define GFX_LAYOUT_PAGES 1 // Vertical bytes, LSB on top (SSD1306 pages)
+
+// Columns per pass; the stack holds 2 * (GFX_BLIT_SPAN + 16) bytes
+#ifndef GFX_BLIT_SPAN
+ #define GFX_BLIT_SPAN 128
+#endif
+
+// Raster ops: how each source pixel s changes destination pixel d
+#define GFX_ROP_COPY   0 // d = s
+#define GFX_ROP_OR     1 // d = d | s   (stamp set pixels)
+#define GFX_ROP_AND    2 // d = d & s
+#define GFX_ROP_XOR    3 // d = d ^ s   (invert under set pixels)
+#define GFX_ROP_ANDNOT 4 // d = d & ~s  (erase under set pixels)
+
+typedef struct { // 1-bit pixel buffer as seen by gfxBlit()
+  uint8_t *buffer;        // Pixel data
+  int16_t  width, height; // Unrotated size in pixels
+  uint8_t  layout;        // GFX_LAYOUT_ROWS or GFX_LAYOUT_PAGES
+} GFXsurface;
+
+// Combine the w x h source rectangle at (sx, sy) into dst at (dx, dy).
+// If 'mask' is given it must match the source's size and layout; only
+// pixels where the mask is set are touched.  Returns false on bad
+// arguments or if a cross-layout blit could not allocate its converted
+// copy; a fully clipped blit succeeds without doing anything.  Same-layout
+// blits don't touch the heap: wide rectangles go in strips of
+// GFX_BLIT_SPAN columns through a scratch line on the stack.
+boolean gfxBlit(const GFXsurface &dst, int16_t dx, int16_t dy,
+          const GFXsurface &src, int16_t sx, int16_t sy, int16_t w, int16_t h,
+          uint8_t rop = GFX_ROP_COPY, const GFXsurface *mask = NULL),
+        gfxBlit(const GFXsurface &dst, int16_t dx, int16_t dy,
+          const GFXsurface &src, uint8_t rop = GFX_ROP_COPY,
+          const GFXsurface *mask = NULL);
+
+// Transpose an 8x8 bit matrix held one row per byte: bit c of byte r
+// becomes bit r of byte c.  Three rounds of swaps between ever larger
+// blocks; the building block of every rows <-> pages conversion.
+static inline uint64_t gfxTranspose8x8(uint64_t m) {
+  uint64_t t;
+  t = (m ^ (m >>  7)) & 0x00AA00AA00AA00AAULL; m ^= t ^ (t <<  7);
+  t = (m ^ (m >> 14)) & 0x0000CCCC0000CCCCULL; m ^= t ^ (t << 14);
+  t = (m ^ (m >> 28)) & 0x00000000F0F0F0F0ULL; m ^= t ^ (t << 28);
+  return m;
+}
+
+#endif // _GFXBLIT_H_
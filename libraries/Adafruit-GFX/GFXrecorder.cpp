@@ -0,0 +1,891 @@
+/*
+Display-list recording and replay for Adafruit_GFX.  See GFXrecorder.h
+for usage.
+
+A list is a byte string of records: an opcode followed by its int16_t
+arguments and, for text and bitmaps, a pointer (font or bitmap).  A static
+group is bracketed by REC_STATIC(id) and REC_END records.  For damage the
+list is split into items -- single calls, or whole static groups -- and
+compared item by item with the previous frame's; each pixel's value only
+depends on the calls covering it, so the boxes of the items that differ
+bound everything that can have changed.
+*/
+
+#include "GFXrecorder.h"
+
+#ifdef __AVR__
+ #include <avr/pgmspace.h>
+#elif defined(ESP8266) || defined(ESP32)
+ #include <pgmspace.h>
+#endif
+
+#ifndef pgm_read_byte
+ #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
+#ifndef pgm_read_word
+ #define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#endif
+#ifndef pgm_read_dword
+ #define pgm_read_dword(addr) (*(const unsigned long *)(addr))
+#endif
+#ifndef pgm_read_pointer
+ #if !defined(__INT_MAX__) || (__INT_MAX__ > 0xFFFF)
+  #define pgm_read_pointer(addr) ((void *)pgm_read_dword(addr))
+ #else
+  #define pgm_read_pointer(addr) ((void *)pgm_read_word(addr))
+ #endif
+#endif
+
+#ifndef min
+#define min(a,b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a,b) (((a) > (b)) ? (a) : (b))
+#endif
+
+// Record opcodes
+#define REC_PIXEL          0
+#define REC_LINE           1
+#define REC_HLINE          2
+#define REC_VLINE          3
+#define REC_RECT           4
+#define REC_FILLRECT       5
+#define REC_FILLSCREEN     6
+#define REC_CHAR           7
+#define REC_CIRCLE         8
+#define REC_FILLCIRCLE     9
+#define REC_TRIANGLE      10
+#define REC_FILLTRIANGLE  11
+#define REC_ROUNDRECT     12
+#define REC_FILLROUNDRECT 13
+#define REC_BITMAP        14
+#define REC_STATIC        15
+#define REC_END           16
+
+// Number of int16_t arguments per opcode; bit 7 set if a pointer follows
+static const uint8_t recArgs[] = {
+  3, 5, 4, 4, 5, 5, 1, 0x80 | 7, 4, 4, 7, 7, 6, 6, 0x80 | 7, 1, 0 };
+
+// REC_CHAR font kinds and REC_BITMAP variants
+#define FONT_CLASSIC  0
+#define FONT_GFX      1
+#define FONT_PROVIDER 2
+#define FONT_PAGE     3 // setPageFont(): glyphs in page layout
+#define BITMAP_PGM    0
+#define BITMAP_PGM_BG 1
+#define BITMAP_RAM    2
+#define BITMAP_RAM_BG 3
+#define BITMAP_XBM    4
+
+#define REC_NONE 0xFFFF // No static group open
+
+static uint16_t decode(const uint8_t *list, uint16_t pos, uint8_t *op,
+ int16_t *a, const void **p) {
+  *op = list[pos++];
+  uint8_t n = recArgs[*op];
+  memcpy(a, &list[pos], (n & 0x7F) * sizeof(int16_t));
+  pos += (n & 0x7F) * sizeof(int16_t);
+  *p   = NULL;
+  if(n & 0x80) {
+    memcpy(p, &list[pos], sizeof(void *));
+    pos += sizeof(void *);
+  }
+  return pos;
+}
+
+// Offset just past the REC_END closing the group whose contents start
+// at 'pos'; 'end' gets the offset of the REC_END record itself
+static uint16_t groupEnd(const uint8_t *list, uint16_t len, uint16_t pos,
+ uint16_t *end) {
+  uint8_t     op;
+  int16_t     a[8];
+  const void *p;
+  while(pos < len) {
+    *end = pos;
+    pos  = decode(list, pos, &op, a, &p);
+    if(op == REC_END) return pos;
+  }
+  *end = len;
+  return len;
+}
+
+// Replay one record.  'font' tracks what was last passed to dst.setFont()
+// so it is only called when the font actually changes (it nudges the
+// cursor when switching between classic and custom fonts).
+static void drawOp(Adafruit_GFX &dst, uint8_t op, const int16_t *a,
+ const void *p, const void **font) {
+  switch(op) {
+   case REC_PIXEL:
+    dst.drawPixel(a[0], a[1], a[2]);
+    break;
+   case REC_LINE:
+    dst.drawLine(a[0], a[1], a[2], a[3], a[4]);
+    break;
+   case REC_HLINE:
+    dst.drawFastHLine(a[0], a[1], a[2], a[3]);
+    break;
+   case REC_VLINE:
+    dst.drawFastVLine(a[0], a[1], a[2], a[3]);
+    break;
+   case REC_RECT:
+    dst.drawRect(a[0], a[1], a[2], a[3], a[4]);
+    break;
+   case REC_FILLRECT:
+    dst.fillRect(a[0], a[1], a[2], a[3], a[4]);
+    break;
+   case REC_FILLSCREEN:
+    dst.fillScreen(a[0]);
+    break;
+   case REC_CHAR:
+    if(p != *font) {
+      if(a[6] == FONT_PROVIDER)  dst.setFont(*(GFXfontProvider *)p);
+      else if(a[6] == FONT_PAGE) dst.setPageFont((const GFXfont *)p);
+      else                       dst.setFont((const GFXfont *)p);
+      *font = p;
+    }
+    dst.drawChar(a[0], a[1], a[2], a[3], a[4], a[5]);
+    break;
+   case REC_CIRCLE:
+    dst.drawCircle(a[0], a[1], a[2], a[3]);
+    break;
+   case REC_FILLCIRCLE:
+    dst.fillCircle(a[0], a[1], a[2], a[3]);
+    break;
+   case REC_TRIANGLE:
+    dst.drawTriangle(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+    break;
+   case REC_FILLTRIANGLE:
+    dst.fillTriangle(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+    break;
+   case REC_ROUNDRECT:
+    dst.drawRoundRect(a[0], a[1], a[2], a[3], a[4], a[5]);
+    break;
+   case REC_FILLROUNDRECT:
+    dst.fillRoundRect(a[0], a[1], a[2], a[3], a[4], a[5]);
+    break;
+   case REC_BITMAP:
+    switch(a[6]) {
+     case BITMAP_PGM:
+      dst.drawBitmap(a[0], a[1], (const uint8_t *)p, a[2], a[3], a[4]);
+      break;
+     case BITMAP_PGM_BG:
+      dst.drawBitmap(a[0], a[1], (const uint8_t *)p, a[2], a[3], a[4], a[5]);
+      break;
+     case BITMAP_RAM:
+      dst.drawBitmap(a[0], a[1], (uint8_t *)p, a[2], a[3], a[4]);
+      break;
+     case BITMAP_RAM_BG:
+      dst.drawBitmap(a[0], a[1], (uint8_t *)p, a[2], a[3], a[4], a[5]);
+      break;
+     case BITMAP_XBM:
+      dst.drawXBitmap(a[0], a[1], (const uint8_t *)p, a[2], a[3], a[4]);
+      break;
+    }
+    break;
+  }
+}
+
+// Marker for "no font set yet" in drawOp()'s font tracking
+static const uint8_t noFont = 0;
+
+static uint32_t hashBytes(const uint8_t *p, uint16_t n) {
+  uint32_t h = 2166136261UL; // FNV-1a
+  while(n--) h = (h ^ *p++) * 16777619UL;
+  return h;
+}
+
+// Which rotation maps the target's drawing coordinates onto 'surface'.
+// Normally the surface is the target's unrotated buffer; an SSD1306 with
+// deferred rotation hands out its frame in the logical orientation.
+static uint8_t surfaceRotation(const Adafruit_GFX &target,
+ const GFXsurface &surface) {
+  uint8_t r = target.getRotation();
+  if((r & 1) && (surface.width != surface.height) &&
+     (surface.width == target.width()) && (surface.height == target.height()))
+    r = 0;
+  return r;
+}
+
+// Map a rectangle from rotated drawing coordinates to those of a W x H
+// unrotated buffer (the inverse of what drawPixel() does per pixel)
+static void mapRect(uint8_t r, int16_t W, int16_t H,
+ int16_t &x, int16_t &y, int16_t &w, int16_t &h) {
+  int16_t t;
+  switch(r) {
+   case 1:
+    t = x; x = W - y - h; y = t;
+    t = w; w = h; h = t;
+    break;
+   case 2:
+    x = W - x - w;
+    y = H - y - h;
+    break;
+   case 3:
+    t = x; x = y; y = H - t - w;
+    t = w; w = h; h = t;
+    break;
+  }
+}
+
+// Forwards drawing to 'target', dropping everything outside a rectangle.
+// Only the primitives are clipped; shapes and text inherit the generic
+// Adafruit_GFX versions, which are built from them.
+class GFXclip : public Adafruit_GFX {
+
+ public:
+  GFXclip(Adafruit_GFX &t, const int16_t *box) :
+   Adafruit_GFX(t.width(), t.height()), target(t) {
+    x0 = box[0]; y0 = box[1]; x1 = box[2]; y1 = box[3];
+  }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if((x >= x0) && (x <= x1) && (y >= y0) && (y <= y1))
+      target.drawPixel(x, y, color);
+  }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillRect(x, y, w, 1, color);
+  }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillRect(x, y, 1, h, color);
+  }
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if(x < x0) { w -= x0 - x; x = x0; }
+    if(y < y0) { h -= y0 - y; y = y0; }
+    if(x + w > x1 + 1) w = x1 + 1 - x;
+    if(y + h > y1 + 1) h = y1 + 1 - y;
+    if((w <= 0) || (h <= 0)) return;
+    if(h == 1)      target.drawFastHLine(x, y, w, color);
+    else if(w == 1) target.drawFastVLine(x, y, h, color);
+    else            target.fillRect(x, y, w, h, color);
+  }
+  void fillScreen(uint16_t color) {
+    target.fillRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1, color);
+  }
+
+ private:
+  Adafruit_GFX &target;
+  int16_t       x0, y0, x1, y1;
+};
+
+// Rasterizes a static group as two masks over its box: every pixel ends
+// up as (pixel & keep) ^ flip, which setting, clearing and inverting all
+// compose into.  Coordinates are those of the target; the masks are in
+// the surface's unrotated layout, ready for gfxBlit().
+class GFXgroupRaster : public Adafruit_GFX {
+
+ public:
+  GFXgroupRaster(const GFXsurface &s, uint8_t r, uint8_t *k, uint8_t *f,
+   int16_t x, int16_t y, int16_t w, int16_t h) :
+   Adafruit_GFX(s.width, s.height) {
+    setRotation(r);
+    keep = k; flip = f; layout = s.layout;
+    bx = x; by = y; bw = w; bh = h;
+  }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return;
+
+    int16_t t;
+    switch(rotation) {
+     case 1:
+      t = x;
+      x = WIDTH  - 1 - y;
+      y = t;
+      break;
+     case 2:
+      x = WIDTH  - 1 - x;
+      y = HEIGHT - 1 - y;
+      break;
+     case 3:
+      t = x;
+      x = y;
+      y = HEIGHT - 1 - t;
+      break;
+    }
+    x -= bx;
+    y -= by;
+    if((x < 0) || (y < 0) || (x >= bw) || (y >= bh)) return;
+
+    int32_t i;
+    uint8_t bit;
+    if(layout == GFX_LAYOUT_ROWS) {
+      i   = (x / 8) + (int32_t)y * ((bw + 7) / 8);
+      bit = 0x80 >> (x & 7);
+    } else {
+      i   = x + (int32_t)(y / 8) * bw;
+      bit = 1 << (y & 7);
+    }
+    if(color > 1) {
+      flip[i] ^= bit;
+    } else {
+      keep[i] &= ~bit;
+      if(color) flip[i] |=  bit;
+      else      flip[i] &= ~bit;
+    }
+  }
+
+ private:
+  uint8_t *keep, *flip, layout;
+  int16_t  bx, by, bw, bh;
+};
+
+GFXrecorder::GFXrecorder(int16_t w, int16_t h) : Adafruit_GFX(w, h) {
+  list        = prev = NULL;
+  len         = prevLen = cap = prevCap = 0;
+  staticStart = REC_NONE;
+  overflow    = ended = prevValid = invalidated = false;
+  frameCount  = 0;
+  nDamage     = 0;
+  memset(groups, 0, sizeof(groups));
+}
+
+GFXrecorder::~GFXrecorder(void) {
+  for(uint8_t i=0; i<GFX_RECORDER_GROUPS; i++) freeGroup(&groups[i]);
+  if(list) free(list);
+  if(prev) free(prev);
+}
+
+// Start recording a new frame; the last one is kept for comparison
+void GFXrecorder::begin(void) {
+  if(ended) {
+    uint8_t *t  = prev;    prev    = list;  list = t;
+    uint16_t tc = prevCap; prevCap = cap;   cap  = tc;
+    prevLen   = len;
+    prevValid = !overflow && !invalidated;
+  }
+  len         = 0;
+  staticStart = REC_NONE;
+  overflow    = ended = false;
+  frameCount++;
+}
+
+// Finish the frame and work out what changed since the previous one
+void GFXrecorder::end(void) {
+  if(staticStart != REC_NONE) endStatic();
+  ended       = true;
+  invalidated = false;
+  nDamage     = 0;
+
+  if(overflow || !prevValid) {
+    int16_t all[4] = { 0, 0, (int16_t)(_width - 1), (int16_t)(_height - 1) };
+    addDamage(all);
+    return;
+  }
+
+  uint16_t a = 0, b = 0;
+  int16_t  boxA[4], boxB[4];
+  while((a < len) || (b < prevLen)) {
+    uint16_t na = a, nb = b;
+    boolean  hasA = (a < len), hasB = (b < prevLen),
+             inA  = hasA && itemBounds(list, len, na, boxA),
+             inB  = hasB && itemBounds(prev, prevLen, nb, boxB);
+    if(!hasA || !hasB || (na - a != nb - b) ||
+       memcmp(&list[a], &prev[b], na - a)) {
+      if(inA) addDamage(boxA);
+      if(inB) addDamage(boxB);
+    }
+    a = na;
+    b = nb;
+  }
+}
+
+// Calls from here to endStatic() are expected to repeat unchanged from
+// frame to frame and are cached as a raster under 'id'
+void GFXrecorder::beginStatic(uint8_t id) {
+  if(staticStart != REC_NONE) return; // Groups don't nest
+  int16_t a[1] = { id };
+  staticStart = len;
+  emit(REC_STATIC, a);
+}
+
+void GFXrecorder::endStatic(void) {
+  if(staticStart == REC_NONE) return;
+  emit(REC_END, NULL);
+  staticStart = REC_NONE;
+}
+
+// Forget cached rasters and the previous frame: the next end() reports the
+// whole screen as damaged.  Needed if the target was drawn on by other
+// means, or bitmaps or fonts changed in place.
+void GFXrecorder::invalidate(void) {
+  for(uint8_t i=0; i<GFX_RECORDER_GROUPS; i++) freeGroup(&groups[i]);
+  prevValid   = false; // For an end() still to come in this frame
+  invalidated = true;  // Or, if ended, for the next one
+}
+
+void GFXrecorder::replay(Adafruit_GFX &target) {
+  run(target, target, NULL, NULL);
+}
+
+void GFXrecorder::replay(Adafruit_GFX &target, const GFXsurface &surface) {
+  run(target, target, &surface, NULL);
+}
+
+void GFXrecorder::replayDamage(Adafruit_GFX &target) {
+  for(uint8_t i=0; i<nDamage; i++) {
+    GFXclip clip(target, damage[i]);
+    run(clip, target, NULL, damage[i]);
+  }
+}
+
+void GFXrecorder::replayDamage(Adafruit_GFX &target,
+ const GFXsurface &surface) {
+  for(uint8_t i=0; i<nDamage; i++) {
+    GFXclip clip(target, damage[i]);
+    run(clip, target, &surface, damage[i]);
+  }
+}
+
+uint8_t GFXrecorder::getDamageCount(void) const {
+  return nDamage;
+}
+
+void GFXrecorder::getDamage(uint8_t i, int16_t *x, int16_t *y,
+ int16_t *w, int16_t *h) {
+  if(i >= nDamage) {
+    *x = *y = *w = *h = 0;
+    return;
+  }
+  *x = damage[i][0];
+  *y = damage[i][1];
+  *w = damage[i][2] - damage[i][0] + 1;
+  *h = damage[i][3] - damage[i][1] + 1;
+}
+
+// Size of the current list in bytes
+uint16_t GFXrecorder::getLength(void) const {
+  return len;
+}
+
+void GFXrecorder::emit(uint8_t op, const int16_t *a, const void *p) {
+  if(overflow) return;
+  uint8_t  n    = recArgs[op];
+  uint16_t size = 1 + (n & 0x7F) * sizeof(int16_t) +
+                  ((n & 0x80) ? sizeof(void *) : 0);
+  if((uint32_t)len + size > cap) {
+    uint32_t c = cap ? (uint32_t)cap * 2 : 256;
+    if(c > 0xFFFF) c = 0xFFFF;
+    uint8_t *l = (len + size <= c) ? (uint8_t *)realloc(list, c) : NULL;
+    if(!l) {
+      overflow = true; // Frame will be reported as fully damaged
+      return;
+    }
+    list = l;
+    cap  = c;
+  }
+  list[len++] = op;
+  if(n & 0x7F) { // 'a' may be NULL for ops without arguments
+    memcpy(&list[len], a, (n & 0x7F) * sizeof(int16_t));
+    len += (n & 0x7F) * sizeof(int16_t);
+  }
+  if(n & 0x80) {
+    memcpy(&list[len], &p, sizeof(void *));
+    len += sizeof(void *);
+  }
+}
+
+void GFXrecorder::run(Adafruit_GFX &dst, Adafruit_GFX &target,
+ const GFXsurface *surface, const int16_t *clip) {
+  uint8_t     op;
+  int16_t     a[8];
+  const void *p, *font = &noFont;
+  uint16_t    pos = 0;
+  // dst's own font, put back afterwards
+  const GFXfont   *dstFont     = dst.getFont(),
+                  *dstPage     = dst.getPageFont();
+  GFXfontProvider *dstProvider = dst.getFontProvider();
+
+  while(pos < len) {
+    pos = decode(list, pos, &op, a, &p);
+    if(op == REC_STATIC) {
+      if(!surface) continue; // Just replay what's inside
+      uint16_t end, next = groupEnd(list, len, pos, &end);
+      Group   *g = cachedGroup(a[0], pos, end, target, *surface);
+      if(!g) continue;       // Couldn't cache it; replay instead
+      pos = next;
+      if(!g->w) continue;    // Draws nothing on screen
+
+      // Blit the part of the box inside the clip rectangle, if any
+      int16_t x = g->x, y = g->y, w = g->w, h = g->h;
+      if(clip) {
+        int16_t cx = clip[0], cy = clip[1],
+                cw = clip[2] - clip[0] + 1, ch = clip[3] - clip[1] + 1;
+        mapRect(g->rotation, surface->width, surface->height, cx, cy, cw, ch);
+        if(cx > x) { w -= cx - x; x = cx; }
+        if(cy > y) { h -= cy - y; y = cy; }
+        if(x + w > cx + cw) w = cx + cw - x;
+        if(y + h > cy + ch) h = cy + ch - y;
+        if((w <= 0) || (h <= 0)) continue;
+      }
+      GFXsurface keep = { g->keep, g->w, g->h, g->layout },
+                 flip = { g->flip, g->w, g->h, g->layout };
+      gfxBlit(*surface, x, y, keep, x - g->x, y - g->y, w, h, GFX_ROP_AND);
+      gfxBlit(*surface, x, y, flip, x - g->x, y - g->y, w, h, GFX_ROP_XOR);
+    } else if(op != REC_END) {
+      drawOp(dst, op, a, p, &font);
+    }
+  }
+  if(font != &noFont) { // Round trip, so the cursor nudges cancel out
+    if(dstProvider)  dst.setFont(*dstProvider);
+    else if(dstPage) dst.setPageFont(dstPage);
+    else             dst.setFont(dstFont);
+  }
+}
+
+// Add a rectangle (x0, y0, x1, y1) to the damage, clipped to the screen.
+// Overlapping rectangles are merged; once all slots are taken the new one
+// is merged into whichever grows least.
+void GFXrecorder::addDamage(const int16_t *box) {
+  int16_t b[4] = { box[0], box[1], box[2], box[3] };
+  if(b[0] < 0) b[0] = 0;
+  if(b[1] < 0) b[1] = 0;
+  if(b[2] >= _width)  b[2] = _width  - 1;
+  if(b[3] >= _height) b[3] = _height - 1;
+  if((b[0] > b[2]) || (b[1] > b[3])) return;
+
+  uint8_t  best = 0;
+  uint32_t bestGrowth = 0xFFFFFFFFUL;
+  for(uint8_t i=0; i<nDamage; i++) {
+    int16_t *d = damage[i];
+    if((b[0] <= d[2] + 1) && (b[2] + 1 >= d[0]) &&
+       (b[1] <= d[3] + 1) && (b[3] + 1 >= d[1])) {
+      best       = i; // Touching: merging costs nothing extra
+      bestGrowth = 0;
+      break;
+    }
+    uint32_t ux = max(b[2], d[2]) - min(b[0], d[0]) + 1,
+             uy = max(b[3], d[3]) - min(b[1], d[1]) + 1,
+             growth = ux * uy - (uint32_t)(d[2] - d[0] + 1) * (d[3] - d[1] + 1);
+    if(growth < bestGrowth) {
+      bestGrowth = growth;
+      best       = i;
+    }
+  }
+  if(bestGrowth && (nDamage < GFX_RECORDER_DAMAGE)) {
+    memcpy(damage[nDamage++], b, sizeof(b));
+    return;
+  }
+  int16_t *d = damage[best];
+  d[0] = min(d[0], b[0]);
+  d[1] = min(d[1], b[1]);
+  d[2] = max(d[2], b[2]);
+  d[3] = max(d[3], b[3]);
+}
+
+// Bounds of the item (call or whole static group) at 'pos', which is
+// advanced past it.  Returns false if it covers nothing on screen.
+boolean GFXrecorder::itemBounds(const uint8_t *l, uint16_t n,
+ uint16_t &pos, int16_t *box) {
+  uint8_t     op;
+  int16_t     a[8], b[4];
+  const void *p;
+
+  box[0] = box[1] = 0x7FFF;
+  box[2] = box[3] = -0x7FFF;
+  pos = decode(l, pos, &op, a, &p);
+  if(op == REC_STATIC) {
+    while(pos < n) {
+      pos = decode(l, pos, &op, a, &p);
+      if(op == REC_END) break;
+      opBounds(op, a, p, b);
+      box[0] = min(box[0], b[0]);
+      box[1] = min(box[1], b[1]);
+      box[2] = max(box[2], b[2]);
+      box[3] = max(box[3], b[3]);
+    }
+  } else {
+    opBounds(op, a, p, box);
+  }
+  return (box[0] <= box[2]) && (box[1] <= box[3]) &&
+         (box[2] >= 0) && (box[3] >= 0) &&
+         (box[0] < _width) && (box[1] < _height);
+}
+
+// Span covered by a run of 'n' pixels from 'a' (the generic line code
+// draws backwards for negative lengths)
+static void span(int16_t a, int16_t n, int16_t &lo, int16_t &hi) {
+  lo = min(a, a + n - 1);
+  hi = max(a, a + n - 1);
+}
+
+// Conservative bounds (x0, y0, x1, y1, inclusive) of one call, in
+// drawing coordinates.  Empty calls get x0 > x1.
+void GFXrecorder::opBounds(uint8_t op, const int16_t *a, const void *p,
+ int16_t *box) {
+  box[0] = box[1] = 0x7FFF;
+  box[2] = box[3] = -0x7FFF;
+  switch(op) {
+   case REC_PIXEL:
+    box[0] = box[2] = a[0];
+    box[1] = box[3] = a[1];
+    break;
+   case REC_LINE:
+    box[0] = min(a[0], a[2]); box[2] = max(a[0], a[2]);
+    box[1] = min(a[1], a[3]); box[3] = max(a[1], a[3]);
+    break;
+   case REC_HLINE:
+    span(a[0], a[2], box[0], box[2]);
+    box[1] = box[3] = a[1];
+    break;
+   case REC_VLINE:
+    box[0] = box[2] = a[0];
+    span(a[1], a[2], box[1], box[3]);
+    break;
+   case REC_RECT:
+   case REC_FILLRECT:
+   case REC_ROUNDRECT:
+   case REC_FILLROUNDRECT:
+   case REC_BITMAP:
+    span(a[0], a[2], box[0], box[2]);
+    span(a[1], a[3], box[1], box[3]);
+    break;
+   case REC_FILLSCREEN:
+    box[0] = box[1] = 0;
+    box[2] = _width  - 1;
+    box[3] = _height - 1;
+    break;
+   case REC_CIRCLE:
+   case REC_FILLCIRCLE:
+    box[0] = a[0] - a[2]; box[2] = a[0] + a[2];
+    box[1] = a[1] - a[2]; box[3] = a[1] + a[2];
+    break;
+   case REC_TRIANGLE:
+   case REC_FILLTRIANGLE:
+    box[0] = min(a[0], min(a[2], a[4])); box[2] = max(a[0], max(a[2], a[4]));
+    box[1] = min(a[1], min(a[3], a[5])); box[3] = max(a[1], max(a[3], a[5]));
+    break;
+   case REC_CHAR: {
+    int16_t  x = a[0], y = a[1], s = a[5];
+    uint8_t  c = a[2];
+    if(a[6] == FONT_CLASSIC) {
+      box[0] = x; box[2] = x + 6 * s - 1;
+      box[1] = y; box[3] = y + 8 * s - 1;
+      break;
+    }
+    const GFXfont *f = (const GFXfont *)p;
+    if(a[6] == FONT_PROVIDER) {
+      GFXfontProvider *fp = (GFXfontProvider *)p;
+      f = fp->getFont();
+      if((c >= f->first) && (c <= f->last)) fp->loadMetrics(c);
+    }
+    uint8_t first = pgm_read_byte(&f->first), last = pgm_read_byte(&f->last);
+    if((c < first) || (c > last)) break;
+    GFXglyph *g  = &(((GFXglyph *)pgm_read_pointer(&f->glyph))[c - first]);
+    uint8_t   gw = pgm_read_byte(&g->width),
+              gh = pgm_read_byte(&g->height);
+    int8_t    xo = pgm_read_byte(&g->xOffset),
+              yo = pgm_read_byte(&g->yOffset);
+    if(!gw || !gh) break;
+    box[0] = x + xo * s; box[2] = x + (xo + gw) * s - 1;
+    box[1] = y + yo * s; box[3] = y + (yo + gh) * s - 1;
+    break;
+   }
+  }
+}
+
+// Find or make the cached raster of the static group 'id' whose calls
+// span list[start..end).  Returns NULL if memory runs out.
+GFXrecorder::Group *GFXrecorder::cachedGroup(uint8_t id, uint16_t start,
+ uint16_t end, Adafruit_GFX &target, const GFXsurface &surface) {
+  uint32_t hash = hashBytes(&list[start], end - start);
+  uint8_t  r    = surfaceRotation(target, surface);
+  Group   *g    = NULL;
+
+  for(uint8_t i=0; i<GFX_RECORDER_GROUPS; i++) {
+    if(groups[i].valid && (groups[i].id == id)) {
+      g = &groups[i];
+      if((g->hash == hash) && (g->layout == surface.layout) &&
+         (g->rotation == r) && (g->sw == surface.width) &&
+         (g->sh == surface.height)) {
+        g->used = frameCount;
+        return g;
+      }
+      freeGroup(g); // Stale: redraw it
+      break;
+    }
+  }
+  if(!g) {
+    g = &groups[0]; // Free slot, else the least recently used one
+    for(uint8_t i=0; i<GFX_RECORDER_GROUPS; i++) {
+      if(!groups[i].valid) { g = &groups[i]; break; }
+      if(groups[i].used < g->used) g = &groups[i];
+    }
+    freeGroup(g);
+  }
+
+  // Box of the group on screen, then in surface coordinates
+  uint8_t     op;
+  int16_t     a[8], b[4], box[4] = { 0x7FFF, 0x7FFF, -0x7FFF, -0x7FFF };
+  const void *p;
+  for(uint16_t pos = start; pos < end; ) {
+    pos = decode(list, pos, &op, a, &p);
+    opBounds(op, a, p, b);
+    box[0] = min(box[0], b[0]);
+    box[1] = min(box[1], b[1]);
+    box[2] = max(box[2], b[2]);
+    box[3] = max(box[3], b[3]);
+  }
+  if(box[0] < 0) box[0] = 0;
+  if(box[1] < 0) box[1] = 0;
+  if(box[2] >= target.width())  box[2] = target.width()  - 1;
+  if(box[3] >= target.height()) box[3] = target.height() - 1;
+
+  g->id       = id;
+  g->hash     = hash;
+  g->used     = frameCount;
+  g->layout   = surface.layout;
+  g->rotation = r;
+  g->sw       = surface.width;
+  g->sh       = surface.height;
+  g->x = g->y = g->w = g->h = 0;
+  if((box[0] > box[2]) || (box[1] > box[3])) {
+    g->valid = true; // Nothing visible; remember that much
+    return g;
+  }
+
+  int16_t x = box[0], y = box[1],
+          w = box[2] - box[0] + 1, h = box[3] - box[1] + 1;
+  mapRect(r, surface.width, surface.height, x, y, w, h);
+  uint32_t bytes = (surface.layout == GFX_LAYOUT_ROWS) ?
+    (uint32_t)((w + 7) / 8) * h : (uint32_t)w * ((h + 7) / 8);
+  g->keep = (uint8_t *)malloc(bytes);
+  g->flip = (uint8_t *)malloc(bytes);
+  if(!g->keep || !g->flip) {
+    freeGroup(g);
+    return NULL;
+  }
+  memset(g->keep, 0xFF, bytes);
+  memset(g->flip, 0x00, bytes);
+
+  GFXgroupRaster raster(surface, r, g->keep, g->flip, x, y, w, h);
+  const void    *font = &noFont;
+  for(uint16_t pos = start; pos < end; ) {
+    pos = decode(list, pos, &op, a, &p);
+    drawOp(raster, op, a, p, &font);
+  }
+  g->x = x; g->y = y; g->w = w; g->h = h;
+  g->valid = true;
+  return g;
+}
+
+void GFXrecorder::freeGroup(Group *g) {
+  if(g->keep) free(g->keep);
+  if(g->flip) free(g->flip);
+  g->keep  = g->flip = NULL;
+  g->valid = false;
+}
+
+// Recording.  Each call becomes one record, arguments as given.
+
+void GFXrecorder::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  int16_t a[] = { x, y, (int16_t)color };
+  emit(REC_PIXEL, a);
+}
+
+void GFXrecorder::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+ uint16_t color) {
+  int16_t a[] = { x0, y0, x1, y1, (int16_t)color };
+  emit(REC_LINE, a);
+}
+
+void GFXrecorder::drawFastVLine(int16_t x, int16_t y, int16_t h,
+ uint16_t color) {
+  int16_t a[] = { x, y, h, (int16_t)color };
+  emit(REC_VLINE, a);
+}
+
+void GFXrecorder::drawFastHLine(int16_t x, int16_t y, int16_t w,
+ uint16_t color) {
+  int16_t a[] = { x, y, w, (int16_t)color };
+  emit(REC_HLINE, a);
+}
+
+void GFXrecorder::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
+ uint16_t color) {
+  int16_t a[] = { x, y, w, h, (int16_t)color };
+  emit(REC_RECT, a);
+}
+
+void GFXrecorder::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+ uint16_t color) {
+  int16_t a[] = { x, y, w, h, (int16_t)color };
+  emit(REC_FILLRECT, a);
+}
+
+void GFXrecorder::fillScreen(uint16_t color) {
+  int16_t a[] = { (int16_t)color };
+  emit(REC_FILLSCREEN, a);
+}
+
+void GFXrecorder::drawChar(int16_t x, int16_t y, unsigned char c,
+ uint16_t color, uint16_t bg, uint8_t size) {
+  int16_t a[] = { x, y, c, (int16_t)color, (int16_t)bg, size,
+    (int16_t)(fontProvider ? FONT_PROVIDER : pageFont ? FONT_PAGE :
+              gfxFont ? FONT_GFX : FONT_CLASSIC) };
+  emit(REC_CHAR, a,
+    fontProvider ? (const void *)fontProvider : (const void *)gfxFont);
+}
+
+void GFXrecorder::drawCircle(int16_t x0, int16_t y0, int16_t r,
+ uint16_t color) {
+  int16_t a[] = { x0, y0, r, (int16_t)color };
+  emit(REC_CIRCLE, a);
+}
+
+void GFXrecorder::fillCircle(int16_t x0, int16_t y0, int16_t r,
+ uint16_t color) {
+  int16_t a[] = { x0, y0, r, (int16_t)color };
+  emit(REC_FILLCIRCLE, a);
+}
+
+void GFXrecorder::drawTriangle(int16_t x0, int16_t y0, int16_t x1,
+ int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+  int16_t a[] = { x0, y0, x1, y1, x2, y2, (int16_t)color };
+  emit(REC_TRIANGLE, a);
+}
+
+void GFXrecorder::fillTriangle(int16_t x0, int16_t y0, int16_t x1,
+ int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+  int16_t a[] = { x0, y0, x1, y1, x2, y2, (int16_t)color };
+  emit(REC_FILLTRIANGLE, a);
+}
+
+void GFXrecorder::drawRoundRect(int16_t x, int16_t y, int16_t w,
+ int16_t h, int16_t r, uint16_t color) {
+  int16_t a[] = { x, y, w, h, r, (int16_t)color };
+  emit(REC_ROUNDRECT, a);
+}
+
+void GFXrecorder::fillRoundRect(int16_t x, int16_t y, int16_t w,
+ int16_t h, int16_t r, uint16_t color) {
+  int16_t a[] = { x, y, w, h, r, (int16_t)color };
+  emit(REC_FILLROUNDRECT, a);
+}
+
+void GFXrecorder::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+ int16_t w, int16_t h, uint16_t color) {
+  int16_t a[] = { x, y, w, h, (int16_t)color, 0, BITMAP_PGM };
+  emit(REC_BITMAP, a, bitmap);
+}
+
+void GFXrecorder::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+ int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  int16_t a[] = { x, y, w, h, (int16_t)color, (int16_t)bg, BITMAP_PGM_BG };
+  emit(REC_BITMAP, a, bitmap);
+}
+
+void GFXrecorder::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+ int16_t w, int16_t h, uint16_t color) {
+  int16_t a[] = { x, y, w, h, (int16_t)color, 0, BITMAP_RAM };
+  emit(REC_BITMAP, a, bitmap);
+}
+
+void GFXrecorder::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+ int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  int16_t a[] = { x, y, w, h, (int16_t)color, (int16_t)bg, BITMAP_RAM_BG };
+  emit(REC_BITMAP, a, bitmap);
+}
+
+void GFXrecorder::drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+ int16_t w, int16_t h, uint16_t color) {
+  int16_t a[] = { x, y, w, h, (int16_t)color, 0, BITMAP_XBM };
+  emit(REC_BITMAP, a, bitmap);
+}
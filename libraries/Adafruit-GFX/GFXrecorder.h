@@ -0,0 +1,130 @@
+#ifndef _GFXRECORDER_H_
+#define _GFXRECORDER_H_
+
+#include "Adafruit_GFX.h"
+
+#define GFX_RECORDER_GROUPS 4 // Static groups whose raster is cached
+#define GFX_RECORDER_DAMAGE 4 // Damage rectangles kept per frame
+
+// Records drawing calls (primitives, text, bitmaps) into a compact display
+// list instead of drawing them, for replay onto any Adafruit_GFX target:
+//
+//   GFXrecorder rec(display.width(), display.height());
+//   rec.begin();
+//   rec.beginStatic(0);              // Same every frame: frame, labels...
+//   rec.fillScreen(BLACK);
+//   rec.drawRect(0, 0, 128, 64, WHITE);
+//   rec.setCursor(4, 4); rec.print("Pressure");
+//   rec.endStatic();
+//   rec.setCursor(4, 20); rec.print(hPa); // Changes from frame to frame
+//   rec.end();
+//   rec.replay(display, display.getSurface());
+//
+// Given the target's 1-bit surface (see GFXblit.h), each static group is
+// rasterized once into a cached pair of masks and afterwards composited
+// with two blits; it is only redrawn when its recorded calls change.
+// Without a surface every call is replayed as-is.
+//
+// end() compares the list with the previous frame's and collects the
+// screen areas whose calls differ as damage rectangles.  replayDamage()
+// redraws just those areas (clipped), which is exact as long as the list
+// paints its own background, e.g. starts with fillScreen().
+//
+// Colors are passed through untouched, but cached static groups assume a
+// monochrome target: 0 clears, 1 sets and anything else inverts (as
+// BLACK, WHITE and INVERSE on the SSD1306).  Bitmaps and fonts are
+// recorded by address and must stay valid until replayed; a bitmap whose
+// contents change under the same address isn't noticed.  Replaying
+// leaves the target's font as it was.  Coordinates are replayed as
+// recorded, so the target should have the recorder's size and rotation.
+
+class GFXrecorder : public Adafruit_GFX {
+
+ public:
+  GFXrecorder(int16_t w, int16_t h);
+  ~GFXrecorder(void);
+
+  void
+    begin(void),
+    end(void),
+    beginStatic(uint8_t id),
+    endStatic(void),
+    invalidate(void),
+    replay(Adafruit_GFX &target),
+    replay(Adafruit_GFX &target, const GFXsurface &surface),
+    replayDamage(Adafruit_GFX &target),
+    replayDamage(Adafruit_GFX &target, const GFXsurface &surface),
+    getDamage(uint8_t i, int16_t *x, int16_t *y, int16_t *w, int16_t *h);
+  uint8_t
+    getDamageCount(void) const;
+  uint16_t
+    getLength(void) const;
+
+  void
+    drawPixel(int16_t x, int16_t y, uint16_t color),
+    drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color),
+    drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color),
+    drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color),
+    drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
+    fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
+    fillScreen(uint16_t color),
+    drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+      uint16_t bg, uint8_t size),
+    drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color),
+    fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color),
+    drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+      int16_t x2, int16_t y2, uint16_t color),
+    fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+      int16_t x2, int16_t y2, uint16_t color),
+    drawRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h,
+      int16_t radius, uint16_t color),
+    fillRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h,
+      int16_t radius, uint16_t color),
+    drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+      int16_t w, int16_t h, uint16_t color),
+    drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+      int16_t w, int16_t h, uint16_t color, uint16_t bg),
+    drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+      int16_t w, int16_t h, uint16_t color),
+    drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+      int16_t w, int16_t h, uint16_t color, uint16_t bg),
+    drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+      int16_t w, int16_t h, uint16_t color);
+
+ private:
+  struct Group {  // Cached raster of a static group
+    uint8_t  *keep, *flip; // Result = (pixel & keep) ^ flip, over the box
+    uint32_t  hash;        // Of the recorded calls it was made from
+    uint32_t  used;        // Frame last used, for eviction
+    int16_t   x, y, w, h;  // Box in surface (unrotated) coordinates
+    int16_t   sw, sh;      // Surface it was made for
+    uint8_t   id, layout, rotation;
+    boolean   valid;
+  };
+
+  void emit(uint8_t op, const int16_t *a, const void *p = NULL);
+  void run(Adafruit_GFX &dst, Adafruit_GFX &target,
+         const GFXsurface *surface, const int16_t *clip);
+  void addDamage(const int16_t *box);
+  boolean itemBounds(const uint8_t *list, uint16_t len, uint16_t &pos,
+            int16_t *box);
+  void opBounds(uint8_t op, const int16_t *a, const void *p, int16_t *box);
+  Group *cachedGroup(uint8_t id, uint16_t start, uint16_t end,
+           Adafruit_GFX &target, const GFXsurface &surface);
+  void freeGroup(Group *g);
+
+  uint8_t  *list, *prev;        // This frame's and last frame's lists
+  uint16_t  len, prevLen,
+            cap, prevCap,
+            staticStart;        // Offset of the open group, 0xFFFF = none
+  boolean   overflow,           // Ran out of memory this frame
+            ended,              // end() called; list becomes 'prev'
+            prevValid,
+            invalidated;        // invalidate() since the last end()
+  uint32_t  frameCount;
+  int16_t   damage[GFX_RECORDER_DAMAGE][4]; // x0, y0, x1, y1 inclusive
+  uint8_t   nDamage;
+  Group     groups[GFX_RECORDER_GROUPS];
+};
+
+#endif // _GFXRECORDER_H_
@@ -0,0 +1,99 @@
+// Throughput benchmark for GFXcanvas16 off-screen drawing.
+// Compares the vectorized fills against the generic per-pixel path and
+// reports megapixels per second for each primitive.  Runs anywhere the
+// canvas fits in RAM (Raspberry Pi, x86 host, larger ARM boards).
+
+#include <Adafruit_GFX.h>
+
+#define CANVAS_W 320
+#define CANVAS_H 240
+#define ROUNDS   50
+
+GFXcanvas16 canvas(CANVAS_W, CANVAS_H);
+
+// Same canvas, but every fill goes through drawPixel() like it used to
+class SlowCanvas16 : public GFXcanvas16 {
+ public:
+  SlowCanvas16(uint16_t w, uint16_t h) : GFXcanvas16(w, h) { }
+  void fillScreen(uint16_t color) {
+    for(int16_t y=0; y<height(); y++)
+      for(int16_t x=0; x<width(); x++) drawPixel(x, y, color);
+  }
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for(int16_t j=y; j<y+h; j++)
+      for(int16_t i=x; i<x+w; i++) drawPixel(i, j, color);
+  }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    for(int16_t i=x; i<x+w; i++) drawPixel(i, y, color);
+  }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    for(int16_t j=y; j<y+h; j++) drawPixel(x, j, color);
+  }
+};
+
+SlowCanvas16 slow(CANVAS_W, CANVAS_H);
+
+void report(const char *name, unsigned long us, unsigned long pixels) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(us);
+  Serial.print(" us, ");
+  Serial.print(us ? (float)pixels / us : 0.0, 1);
+  Serial.println(" Mpixel/s");
+}
+
+void bench(Adafruit_GFX &gfx, const char *label) {
+  unsigned long t, pixels;
+  uint16_t      w = gfx.width(), h = gfx.height();
+
+  Serial.println(label);
+
+  t = micros();
+  for(uint16_t i=0; i<ROUNDS; i++) gfx.fillScreen(0x1234 + i);
+  report("  fillScreen   ", micros() - t, (unsigned long)ROUNDS * w * h);
+
+  t = micros();
+  pixels = 0;
+  for(uint16_t i=0; i<ROUNDS; i++) {
+    for(uint16_t y=0; y<h; y+=4) {
+      gfx.fillRect(y & 31, y, w - 40, 3, 0xF800 + i);
+      pixels += (unsigned long)(w - 40) * 3;
+    }
+  }
+  report("  fillRect     ", micros() - t, pixels);
+
+  t = micros();
+  pixels = 0;
+  for(uint16_t i=0; i<ROUNDS; i++) {
+    for(uint16_t y=0; y<h; y++) {
+      gfx.drawFastHLine(i & 7, y, w - 8, 0x07E0 + i);
+      pixels += w - 8;
+    }
+  }
+  report("  drawFastHLine", micros() - t, pixels);
+
+  t = micros();
+  pixels = 0;
+  for(uint16_t i=0; i<ROUNDS; i++) {
+    for(uint16_t x=0; x<w; x++) {
+      gfx.drawFastVLine(x, i & 7, h - 8, 0x001F + i);
+      pixels += h - 8;
+    }
+  }
+  report("  drawFastVLine", micros() - t, pixels);
+}
+
+void setup() {
+  Serial.begin(115200);
+  if(!canvas.getBuffer() || !slow.getBuffer()) {
+    Serial.println("Not enough RAM for canvases");
+    return;
+  }
+  bench(slow,   "Per-pixel:");
+  bench(canvas, "GFXcanvas16:");
+  canvas.setRotation(1);
+  bench(canvas, "GFXcanvas16, rotation 1:");
+}
+
+void loop() {
+}
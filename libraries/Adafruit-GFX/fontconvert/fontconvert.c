@@ -8,6 +8,20 @@ fonts to be used with the Adafruit_GFX Arduino library.
 For UNIX-like systems.  Outputs to stdout; redirect to header file, e.g.:
   ./fontconvert ~/Library/Fonts/FreeSans.ttf 18 > FreeSans18pt7b.h
 
+Batch mode converts every font file x size combination in one process,
+spread over worker threads, writing one .h per combination into a
+directory (file names as makefonts.sh used to produce), e.g.:
+  ./fontconvert -o ../Fonts -s 9,12,18,24 -j 4 FreeSans.ttf FreeSerif.ttf
+
+-p writes bitmaps in page format (column-major, 8 vertical pixels per
+byte, LSB on top -- the SSD1306 frame buffer layout) for drawing with
+setPageFont().  Table names get a 'Pg' suffix.
+
+-c charfile limits either mode to the characters that appear in charfile
+(newlines ignored).  The first/last range shrinks to fit and glyphs not
+in the file are emitted as empty entries, so tables only carry bitmaps
+for text the project actually renders.
+
 REQUIRES FREETYPE LIBRARY.  www.freetype.org
 
 Currently this only extracts the printable 7-bit ASCII chars of a font.
@@ -18,39 +32,132 @@ See notes at end for glyph nomenclature & other tidbits.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
 #include <ctype.h>
 #include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include <ft2build.h>
 #include FT_GLYPH_H
 #include "../gfxfont.h" // Adafruit_GFX font structures
 
 #define DPI 141 // Approximate res. of Adafruit 2.8" TFT
 
-// Accumulate bits for output, with periodic hexadecimal byte write
-void enbit(uint8_t value) {
-	static uint8_t row = 0, sum = 0, bit = 0x80, firstCall = 1;
-	if(value) sum |= bit;    // Set bit if needed
-	if(!(bit >>= 1)) {       // Advance to next bit, end of byte reached?
-		if(!firstCall) { // Format output table nicely
-			if(++row >= 12) {        // Last entry on line?
-				printf(",\n  "); //   Newline format output
-				row = 0;         //   Reset row counter
-			} else {                 // Not end of line
-				printf(", ");    //   Simple comma delim
-			}
+// Converted output is accumulated in memory and written with a single
+// fwrite() per font, rather than a printf() per bitmap byte.
+typedef struct {
+	char   *data;
+	size_t  len, size;
+	int     failed;          // Out of memory
+	uint8_t row, sum, bit;   // enbit() state
+	uint8_t firstCall;
+} Output;
+
+static void outInit(Output *out) {
+	memset(out, 0, sizeof(Output));
+	out->bit       = 0x80;
+	out->firstCall = 1;
+}
+
+static void outPrintf(Output *out, const char *fmt, ...) {
+	va_list ap;
+	int     n;
+
+	if(out->failed) return;
+	for(;;) {
+		va_start(ap, fmt);
+		n = vsnprintf(out->data + out->len, out->size - out->len, fmt, ap);
+		va_end(ap);
+		if(n < 0) {
+			out->failed = 1;
+			return;
 		}
-		printf("0x%02X", sum); // Write byte value
-		sum       = 0;         // Clear for next byte
-		bit       = 0x80;      // Reset bit counter
-		firstCall = 0;         // Formatting flag
+		if(out->len + n < out->size) break;
+		// Grow buffer and retry
+		size_t newSize = out->size ? out->size * 2 : 16384;
+		while(newSize <= out->len + n) newSize *= 2;
+		char *p = realloc(out->data, newSize);
+		if(!p) {
+			out->failed = 1;
+			return;
+		}
+		out->data = p;
+		out->size = newSize;
 	}
+	out->len += n;
 }
 
-int main(int argc, char *argv[]) {
-	int                i, j, err, size, first=' ', last='~',
-	                   bitmapOffset = 0, x, y, byte;
-	char              *fontName, c, *ptr;
-	FT_Library         library;
+// Write hexadecimal byte to bitmap table
+void enbyte(Output *out, uint8_t value) {
+	if(!out->firstCall) { // Format output table nicely
+		if(++out->row >= 12) {        // Last entry on line?
+			outPrintf(out, ",\n  "); //   Newline format output
+			out->row = 0;         //   Reset row counter
+		} else {                      // Not end of line
+			outPrintf(out, ", ");    //   Simple comma delim
+		}
+	}
+	outPrintf(out, "0x%02X", value); // Write byte value
+	out->firstCall = 0;              // Formatting flag
+}
+
+// Accumulate bits for output, with periodic hexadecimal byte write
+void enbit(Output *out, uint8_t value) {
+	if(value) out->sum |= out->bit; // Set bit if needed
+	if(!(out->bit >>= 1)) {         // Advance to next bit, end of byte reached?
+		enbyte(out, out->sum);
+		out->sum       = 0;         // Clear for next byte
+		out->bit       = 0x80;      // Reset bit counter
+	}
+}
+
+// Derive font table name from filename.  Path and period (filename
+// extension) are stripped and replaced with the font size & bits, space
+// and punctuation chars replaced w/ underscores.  Returns malloc'd string.
+static char *makeFontName(const char *filename, int size, int last,
+  int pages) {
+	const char *ptr;
+	char       *fontName, *ext, c;
+	int         i;
+
+	ptr = strrchr(filename, '/'); // Find last slash in filename
+	if(ptr) ptr++;            // First character of filename (path stripped)
+	else    ptr = filename;   // No path; font in local dir.
+
+	// Alloc'd w/extra space for the suffix, we're not sprintfing
+	// into Forbidden Zone.
+	if(!(fontName = malloc(strlen(ptr) + 20))) return NULL;
+	strcpy(fontName, ptr);
+	ext = strrchr(fontName, '.'); // Find last period (file ext)
+	if(!ext) ext = &fontName[strlen(fontName)]; // If none, append
+	sprintf(ext, "%dpt%db%s", size, (last > 127) ? 8 : 7, pages ? "Pg" : "");
+	for(i=0; (c=fontName[i]); i++) {
+		if(isspace(c) || ispunct(c)) fontName[i] = '_';
+	}
+	return fontName;
+}
+
+// Shrink the first/last range to the characters 'subset' actually uses
+// (if given).  The table name's 7/8 bit suffix depends on the result, so
+// anything naming a table first must shrink the same way.
+static void shrinkRange(const uint8_t *subset, int *first, int *last) {
+	if(!subset) return;
+	if(*last > 255) *last = 255; // Past the end of 'subset'
+	while((*first < *last) && !subset[*first]) (*first)++;
+	while((*last > *first) && !subset[*last])  (*last)--;
+}
+
+// Convert one font file at one size to a GFXfont header in 'out'.
+// 'subset' (256 flags, or NULL for all) selects the glyphs that get
+// bitmaps; 'pages' selects page-format bitmaps.  Returns 0 or a FreeType
+// error.
+static int convert(FT_Library library, const char *filename, int size,
+  int first, int last, const uint8_t *subset, int pages, Output *out) {
+	int                i, j, n, err, bitmapOffset = 0, x, y, byte;
+	char              *fontName;
 	FT_Face            face;
 	FT_Glyph           glyph;
 	FT_Bitmap         *bitmap;
@@ -58,67 +165,21 @@ int main(int argc, char *argv[]) {
 	GFXglyph          *table;
 	uint8_t            bit;
 
-	// Parse command line.  Valid syntaxes are:
-	//   fontconvert [filename] [size]
-	//   fontconvert [filename] [size] [last char]
-	//   fontconvert [filename] [size] [first char] [last char]
-	// Unless overridden, default first and last chars are
-	// ' ' (space) and '~', respectively
-
-	if(argc < 3) {
-		fprintf(stderr, "Usage: %s fontfile size [first] [last]\n",
-		  argv[0]);
-		return 1;
-	}
-
-	size = atoi(argv[2]);
-
-	if(argc == 4) {
-		last  = atoi(argv[3]);
-	} else if(argc == 5) {
-		first = atoi(argv[3]);
-		last  = atoi(argv[4]);
-	}
-
-	if(last < first) {
-		i     = first;
-		first = last;
-		last  = i;
-	}
-
-	ptr = strrchr(argv[1], '/'); // Find last slash in filename
-	if(ptr) ptr++;         // First character of filename (path stripped)
-	else    ptr = argv[1]; // No path; font in local dir.
+	shrinkRange(subset, &first, &last);
 
 	// Allocate space for font name and glyph table
-	if((!(fontName = malloc(strlen(ptr) + 20))) ||
-	   (!(table = (GFXglyph *)malloc((last - first + 1) *
+	if((!(fontName = makeFontName(filename, size, last, pages))) ||
+	   (!(table = (GFXglyph *)calloc(last - first + 1,
 	    sizeof(GFXglyph))))) {
 		fprintf(stderr, "Malloc error\n");
+		free(fontName);
 		return 1;
 	}
 
-	// Derive font table names from filename.  Period (filename
-	// extension) is truncated and replaced with the font size & bits.
-	strcpy(fontName, ptr);
-	ptr = strrchr(fontName, '.'); // Find last period (file ext)
-	if(!ptr) ptr = &fontName[strlen(fontName)]; // If none, append
-	// Insert font size and 7/8 bit.  fontName was alloc'd w/extra
-	// space to allow this, we're not sprintfing into Forbidden Zone.
-	sprintf(ptr, "%dpt%db", size, (last > 127) ? 8 : 7);
-	// Space and punctuation chars in name replaced w/ underscores.  
-	for(i=0; (c=fontName[i]); i++) {
-		if(isspace(c) || ispunct(c)) fontName[i] = '_';
-	}
-
-	// Init FreeType lib, load font
-	if((err = FT_Init_FreeType(&library))) {
-		fprintf(stderr, "FreeType init error: %d", err);
-		return err;
-	}
-	if((err = FT_New_Face(library, argv[1], 0, &face))) {
+	if((err = FT_New_Face(library, filename, 0, &face))) {
 		fprintf(stderr, "Font load error: %d", err);
-		FT_Done_FreeType(library);
+		free(table);
+		free(fontName);
 		return err;
 	}
 
@@ -131,10 +192,19 @@ int main(int argc, char *argv[]) {
 	// the right symbols, and that's not done yet.
 	// fprintf(stderr, "%ld glyphs\n", face->num_glyphs);
 
-	printf("const uint8_t %sBitmaps[] PROGMEM = {\n  ", fontName);
+	if(pages) {
+		outPrintf(out, "// Page-format bitmaps: select with "
+		  "setPageFont(), not setFont()\n\n");
+	}
+	outPrintf(out, "const uint8_t %sBitmaps[] PROGMEM = {\n  ", fontName);
 
 	// Process glyphs and output huge bitmap data array
 	for(i=first, j=0; i<=last; i++, j++) {
+		table[j].bitmapOffset = bitmapOffset;
+		// Characters outside the subset keep an empty entry, so
+		// the table stays indexable by (c - first)
+		if(subset && !subset[i]) continue;
+
 		// MONO renderer provides clean image with perfect crop
 		// (no wasted pixels) via bitmap struct.
 		if((err = FT_Load_Char(face, i, FT_LOAD_TARGET_MONO))) {
@@ -167,39 +237,59 @@ int main(int argc, char *argv[]) {
 		// code currently doesn't check for overflow.  (Doesn't
 		// check that size & offsets are within bounds either for
 		// that matter...please convert fonts responsibly.)
-		table[j].bitmapOffset = bitmapOffset;
 		table[j].width        = bitmap->width;
 		table[j].height       = bitmap->rows;
 		table[j].xAdvance     = face->glyph->advance.x >> 6;
 		table[j].xOffset      = g->left;
 		table[j].yOffset      = 1 - g->top;
 
-		for(y=0; y < bitmap->rows; y++) {
-			for(x=0;x < bitmap->width; x++) {
-				byte = x / 8;
-				bit  = 0x80 >> (x & 7);
-				enbit(bitmap->buffer[
-				  y * bitmap->pitch + byte] & bit);
+		if(pages) {
+			// Page format: for each band of 8 rows, one byte per
+			// column, top row in bit 0.  Rows past the bottom of the
+			// glyph are zero, so the display can OR whole bytes in.
+			for(y=0; y < bitmap->rows; y += 8) {
+				for(x=0; x < bitmap->width; x++) {
+					uint8_t col = 0;
+					byte = x / 8;
+					bit  = 0x80 >> (x & 7);
+					for(n=0; (n < 8) && (y + n < bitmap->rows); n++) {
+						if(bitmap->buffer[(y + n) *
+						  bitmap->pitch + byte] & bit) {
+							col |= 1 << n;
+						}
+					}
+					enbyte(out, col);
+				}
+			}
+			bitmapOffset += bitmap->width * ((bitmap->rows + 7) / 8);
+		} else {
+			for(y=0; y < bitmap->rows; y++) {
+				for(x=0;x < bitmap->width; x++) {
+					byte = x / 8;
+					bit  = 0x80 >> (x & 7);
+					enbit(out, bitmap->buffer[
+					  y * bitmap->pitch + byte] & bit);
+				}
 			}
-		}
 
-		// Pad end of char bitmap to next byte boundary if needed
-		int n = (bitmap->width * bitmap->rows) & 7;
-		if(n) { // Pixel count not an even multiple of 8?
-			n = 8 - n; // # bits to next multiple
-			while(n--) enbit(0);
+			// Pad end of char bitmap to next byte boundary if needed
+			n = (bitmap->width * bitmap->rows) & 7;
+			if(n) { // Pixel count not an even multiple of 8?
+				n = 8 - n; // # bits to next multiple
+				while(n--) enbit(out, 0);
+			}
+			bitmapOffset += (bitmap->width * bitmap->rows + 7) / 8;
 		}
-		bitmapOffset += (bitmap->width * bitmap->rows + 7) / 8;
 
 		FT_Done_Glyph(glyph);
 	}
 
-	printf(" };\n\n"); // End bitmap array
+	outPrintf(out, " };\n\n"); // End bitmap array
 
 	// Output glyph attributes table (one per character)
-	printf("const GFXglyph %sGlyphs[] PROGMEM = {\n", fontName);
+	outPrintf(out, "const GFXglyph %sGlyphs[] PROGMEM = {\n", fontName);
 	for(i=first, j=0; i<=last; i++, j++) {
-		printf("  { %5d, %3d, %3d, %3d, %4d, %4d }",
+		outPrintf(out, "  { %5d, %3d, %3d, %3d, %4d, %4d }",
 		  table[j].bitmapOffset,
 		  table[j].width,
 		  table[j].height,
@@ -207,33 +297,271 @@ int main(int argc, char *argv[]) {
 		  table[j].xOffset,
 		  table[j].yOffset);
 		if(i < last) {
-			printf(",   // 0x%02X", i);
+			outPrintf(out, ",   // 0x%02X", i);
 			if((i >= ' ') && (i <= '~')) {
-				printf(" '%c'", i);
+				outPrintf(out, " '%c'", i);
 			}
-			putchar('\n');
+			outPrintf(out, "\n");
 		}
 	}
-	printf(" }; // 0x%02X", last);
-	if((last >= ' ') && (last <= '~')) printf(" '%c'", last);
-	printf("\n\n");
+	outPrintf(out, " }; // 0x%02X", last);
+	if((last >= ' ') && (last <= '~')) outPrintf(out, " '%c'", last);
+	outPrintf(out, "\n\n");
 
 	// Output font structure
-	printf("const GFXfont %s PROGMEM = {\n", fontName);
-	printf("  (uint8_t  *)%sBitmaps,\n", fontName);
-	printf("  (GFXglyph *)%sGlyphs,\n", fontName);
-	printf("  0x%02X, 0x%02X, %ld };\n\n",
+	outPrintf(out, "const GFXfont %s PROGMEM = {\n", fontName);
+	outPrintf(out, "  (uint8_t  *)%sBitmaps,\n", fontName);
+	outPrintf(out, "  (GFXglyph *)%sGlyphs,\n", fontName);
+	outPrintf(out, "  0x%02X, 0x%02X, %ld };\n\n",
 	  first, last, face->size->metrics.height >> 6);
-	printf("// Approx. %d bytes\n",
+	outPrintf(out, "// Approx. %d bytes\n",
 	  bitmapOffset + (last - first + 1) * 7 + 7);
 	// Size estimate is based on AVR struct and pointer sizes;
 	// actual size may vary.
 
-	FT_Done_FreeType(library);
+	FT_Done_Face(face);
+	free(table);
+	free(fontName);
 
+	return out->failed;
+}
+
+// Read character list file into 256 'used' flags.  Newlines and
+// carriage returns are ignored, everything else (incl. space) counts.
+static int readSubset(const char *filename, uint8_t *subset) {
+	FILE *fp;
+	int   c;
+
+	if(!(fp = fopen(filename, "rb"))) {
+		fprintf(stderr, "Can't open character file %s\n", filename);
+		return 1;
+	}
+	memset(subset, 0, 256);
+	while((c = getc(fp)) != EOF) {
+		if((c != '\n') && (c != '\r')) subset[c] = 1;
+	}
+	fclose(fp);
 	return 0;
 }
 
+// Batch mode: a shared queue of font x size jobs, drained by workers that
+// each own a FreeType library instance (FT_Library is not thread-safe).
+typedef struct {
+	char          **files;
+	int            *sizes;
+	int             nFiles, nSizes, next, errors;
+	int             first, last, pages;
+	const uint8_t  *subset;
+	const char     *outDir;
+	pthread_mutex_t lock;
+} Batch;
+
+static void *worker(void *arg) {
+	Batch     *b = (Batch *)arg;
+	FT_Library library;
+	int        job, err;
+
+	if(FT_Init_FreeType(&library)) {
+		pthread_mutex_lock(&b->lock);
+		b->errors++;
+		pthread_mutex_unlock(&b->lock);
+		return NULL;
+	}
+
+	for(;;) {
+		pthread_mutex_lock(&b->lock);
+		job = b->next++;
+		pthread_mutex_unlock(&b->lock);
+		if(job >= b->nFiles * b->nSizes) break;
+
+		const char *infile = b->files[job / b->nSizes];
+		int         size   = b->sizes[job % b->nSizes],
+		            first  = b->first,
+		            last   = b->last;
+		shrinkRange(b->subset, &first, &last);
+		char       *name   = makeFontName(infile, size, last,
+		                     b->pages),
+		           *path   = name ?
+		                     malloc(strlen(b->outDir) + strlen(name) + 4) :
+		                     NULL;
+		Output      out;
+		FILE       *fp;
+
+		outInit(&out);
+		err = !path;
+		if(!err) {
+			sprintf(path, "%s/%s.h", b->outDir, name);
+			if((err = convert(library, infile, size, first,
+			  last, b->subset, b->pages, &out))) {
+				fprintf(stderr, " (%s)\n", infile);
+			} else if((fp = fopen(path, "w"))) {
+				err = (fwrite(out.data, 1, out.len, fp) != out.len);
+				err |= fclose(fp);
+			} else {
+				err = 1;
+			}
+			if(err) fprintf(stderr, "Can't write %s\n", path);
+		}
+		if(err) {
+			pthread_mutex_lock(&b->lock);
+			b->errors++;
+			pthread_mutex_unlock(&b->lock);
+		}
+		free(out.data);
+		free(path);
+		free(name);
+	}
+
+	FT_Done_FreeType(library);
+	return NULL;
+}
+
+static int batch(Batch *b, int threads) {
+	pthread_t *tid;
+	int        i, n;
+
+	if(threads < 1) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (cpus > 0) ? cpus : 1;
+	}
+	if(threads > b->nFiles * b->nSizes) threads = b->nFiles * b->nSizes;
+	if(!(tid = malloc(threads * sizeof(pthread_t)))) {
+		fprintf(stderr, "Malloc error\n");
+		return 1;
+	}
+	pthread_mutex_init(&b->lock, NULL);
+	for(i=n=0; i<threads; i++) {
+		if(!pthread_create(&tid[n], NULL, worker, b)) n++;
+	}
+	if(!n) worker(b); // No threads to be had, do it ourselves
+	for(i=0; i<n; i++) pthread_join(tid[i], NULL);
+	pthread_mutex_destroy(&b->lock);
+	free(tid);
+	return b->errors ? 1 : 0;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr,
+	  "Usage: %s [-p] [-c charfile] fontfile size [first] [last]\n"
+	  "       %s -o outdir -s size[,size...] [-j threads] [-p] [-c charfile]\n"
+	  "         [-f first] [-l last] fontfile [fontfile...]\n",
+	  name, name);
+}
+
+int main(int argc, char *argv[]) {
+	int         i, err, opt, size, first=' ', last='~', threads=0, pages=0;
+	const char *outDir = NULL, *sizeList = NULL, *name = argv[0];
+	uint8_t     subset[256], *useSubset = NULL;
+	FT_Library  library;
+
+	// Parse command line.  Valid syntaxes are:
+	//   fontconvert [filename] [size]
+	//   fontconvert [filename] [size] [last char]
+	//   fontconvert [filename] [size] [first char] [last char]
+	// Unless overridden, default first and last chars are
+	// ' ' (space) and '~', respectively.  Batch mode (-o) takes
+	// first/last via -f/-l and any number of font files.
+
+	while((opt = getopt(argc, argv, "c:o:s:j:f:l:p")) != -1) {
+		switch(opt) {
+		 case 'c':
+			if(readSubset(optarg, subset)) return 1;
+			useSubset = subset;
+			break;
+		 case 'o': outDir   = optarg;       break;
+		 case 's': sizeList = optarg;       break;
+		 case 'j': threads  = atoi(optarg); break;
+		 case 'f': first    = atoi(optarg); break;
+		 case 'l': last     = atoi(optarg); break;
+		 case 'p': pages    = 1;            break;
+		 default:
+			usage(name);
+			return 1;
+		}
+	}
+	argc -= optind - 1; // Positional args now start at argv[1] (argv[0] is
+	argv += optind - 1; // no longer the program name, hence 'name')
+
+	if(outDir) { // Batch mode
+		Batch b;
+		char *list, *tok;
+
+		if(!sizeList || (argc < 2)) {
+			usage(name);
+			return 1;
+		}
+		memset(&b, 0, sizeof(b));
+		if(!(b.files = malloc(argc * sizeof(char *))) ||
+		   !(b.sizes = malloc((strlen(sizeList) / 2 + 1) *
+		    sizeof(int))) || !(list = strdup(sizeList))) {
+			fprintf(stderr, "Malloc error\n");
+			return 1;
+		}
+		for(tok=strtok(list, ","); tok; tok=strtok(NULL, ",")) {
+			if((size = atoi(tok)) > 0) b.sizes[b.nSizes++] = size;
+		}
+		free(list);
+		for(i=1; i<argc; i++) { // Skip nonexistent combinations
+			struct stat st;
+			if(!stat(argv[i], &st)) b.files[b.nFiles++] = argv[i];
+			else fprintf(stderr, "Skipping %s\n", argv[i]);
+		}
+		if(!b.nFiles || !b.nSizes) return 1;
+		if(last < first) {
+			i     = first;
+			first = last;
+			last  = i;
+		}
+		b.first  = first;
+		b.last   = last;
+		b.subset = useSubset;
+		b.pages  = pages;
+		b.outDir = outDir;
+		err = batch(&b, threads);
+		free(b.files);
+		free(b.sizes);
+		return err;
+	}
+
+	if(argc < 3) {
+		usage(name);
+		return 1;
+	}
+
+	size = atoi(argv[2]);
+
+	if(argc == 4) {
+		last  = atoi(argv[3]);
+	} else if(argc == 5) {
+		first = atoi(argv[3]);
+		last  = atoi(argv[4]);
+	}
+
+	if(last < first) {
+		i     = first;
+		first = last;
+		last  = i;
+	}
+
+	// Init FreeType lib, load font
+	if((err = FT_Init_FreeType(&library))) {
+		fprintf(stderr, "FreeType init error: %d", err);
+		return err;
+	}
+
+	Output out;
+	outInit(&out);
+	if(!(err = convert(library, argv[1], size, first, last, useSubset,
+	  pages, &out))) {
+		fwrite(out.data, 1, out.len, stdout);
+	}
+	free(out.data);
+
+	FT_Done_FreeType(library);
+
+	return err;
+}
+
 /* -------------------------------------------------------------------------
 
 Character metrics are slightly different from classic GFX & ftGFX.
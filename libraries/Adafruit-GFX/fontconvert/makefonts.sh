@@ -5,8 +5,10 @@
 # 'Sans' (Helvetica-like) and 'Serif' (Times-like); four styles: regular,
 # bold, oblique or italic, and bold+oblique or bold+italic; and four
 # sizes: 9, 12, 18 and 24 point.  No real error checking or anything,
-# this just powers through all the combinations, calling the fontconvert
-# utility and redirecting the output to a .h file for each combo.
+# this just collects all the combinations and hands them to a single
+# fontconvert run in batch mode, which writes a .h file for each combo
+# (missing style files are skipped).  Set CHARS to a character list file
+# to generate subset fonts containing only those glyphs.
 
 # Adafruit_GFX repository does not include the source outline fonts
 # (huge zipfile, different license) but they're easily acquired:
@@ -17,22 +19,20 @@ inpath=~/Desktop/freefont/
 outpath=../Fonts/
 fonts=(FreeMono FreeSans FreeSerif)
 styles=("" Bold Italic BoldItalic Oblique BoldOblique)
-sizes=(9 12 18 24)
+sizes=9,12,18,24
 
+infiles=()
 for f in ${fonts[*]}
 do
 	for index in ${!styles[*]}
 	do
 		st=${styles[$index]}
-		for si in ${sizes[*]}
-		do
-			infile=$inpath$f$st".ttf"
-			if [ -f $infile ] # Does source combination exist?
-			  then
-				outfile=$outpath$f$st$si"pt7b.h"
-#				printf "%s %s %s > %s\n" $convert $infile $si $outfile
-				$convert $infile $si > $outfile
-			fi
-		done
+		infile=$inpath$f$st".ttf"
+		if [ -f $infile ] # Does source combination exist?
+		  then
+			infiles+=($infile)
+		fi
 	done
 done
+
+$convert -o $outpath -s $sizes ${CHARS:+-c $CHARS} ${infiles[*]}
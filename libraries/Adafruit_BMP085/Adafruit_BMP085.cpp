@@ -17,7 +17,60 @@
 
 #include "Adafruit_BMP085.h"
 
+#ifdef __AVR__
+ #include <avr/pgmspace.h>
+#elif defined(ESP8266) || defined(ESP32)
+ #include <pgmspace.h>
+#endif
+#ifndef PROGMEM
+ #define PROGMEM
+#endif
+#if defined(__AVR__) || defined(ESP8266) || defined(ESP32)
+ #define readTable(t, i) pgm_read_dword(&(t)[i])
+#else
+ #define readTable(t, i) ((t)[i])
+#endif
+
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+ #include <stdio.h>
+ #include <string.h>
+ #define BMP085_CACHE_FILES
+#endif
+
+// Calibration cache file: "BMPC", version, address, chip id, the PROM
+// bytes as read (22, or 24 for a BMP280), then a Fletcher-16 of all that,
+// little-endian
+#define CACHE_VERSION   1
+#define CACHE_HEADER    8
+
+static Adafruit_BMP085_WireBus wireBus;
+
+static uint16_t be16(const uint8_t *p) {
+  return ((uint16_t)p[0] << 8) | p[1];
+}
+
+static uint16_t le16(const uint8_t *p) {
+  return ((uint16_t)p[1] << 8) | p[0];
+}
+
+// The calibration PROM: where it starts and how long it is
+static uint8_t promStart(uint8_t chip) {
+  return (chip == BMP280_CHIPID) ? BMP280_CAL_T1 : BMP085_CAL_AC1;
+}
+
+static uint8_t promBytes(uint8_t chip) {
+  return (chip == BMP280_CHIPID) ? 24 : 22;
+}
+
 Adafruit_BMP085::Adafruit_BMP085() {
+  bus = &wireBus;
+  cacheDir = NULL;
+  cacheHits = cacheMisses = 0;
+  state = BMP085_IDLE;
+  continuous = false;
+  eoc = -1;
+  b5Valid = false;
+  chip = 0;
 }
 
 
@@ -25,25 +78,39 @@ boolean Adafruit_BMP085::begin(uint8_t mode) {
   if (mode > BMP085_ULTRAHIGHRES) 
     mode = BMP085_ULTRAHIGHRES;
   oversampling = mode;
+  b5Valid = false;
 
-  Wire.begin();
-
-  if (read8(0xD0) != 0x55) return false;
+  bus->begin();
 
-  /* read calibration data */
-  ac1 = read16(BMP085_CAL_AC1);
-  ac2 = read16(BMP085_CAL_AC2);
-  ac3 = read16(BMP085_CAL_AC3);
-  ac4 = read16(BMP085_CAL_AC4);
-  ac5 = read16(BMP085_CAL_AC5);
-  ac6 = read16(BMP085_CAL_AC6);
+  chip = read8(0xD0);
+  if ((chip != BMP085_CHIPID) && (chip != BMP280_CHIPID)) return false;
 
-  b1 = read16(BMP085_CAL_B1);
-  b2 = read16(BMP085_CAL_B2);
-
-  mb = read16(BMP085_CAL_MB);
-  mc = read16(BMP085_CAL_MC);
-  md = read16(BMP085_CAL_MD);
+  /* read calibration data, all 11 (12) words in one transaction */
+  uint8_t cal[24];
+  if (!loadCalibration(cal)) {
+    if (!bus->readRegs(BMP085_I2CADDR, promStart(chip), cal, promBytes(chip)))
+      return false;
+    storeCalibration(cal);
+  }
+  if (chip == BMP280_CHIPID) {
+    setup280(cal);
+    return true;
+  }
+#define CAL(reg) be16(&cal[(reg) - BMP085_CAL_AC1])
+  ac1 = CAL(BMP085_CAL_AC1);
+  ac2 = CAL(BMP085_CAL_AC2);
+  ac3 = CAL(BMP085_CAL_AC3);
+  ac4 = CAL(BMP085_CAL_AC4);
+  ac5 = CAL(BMP085_CAL_AC5);
+  ac6 = CAL(BMP085_CAL_AC6);
+
+  b1 = CAL(BMP085_CAL_B1);
+  b2 = CAL(BMP085_CAL_B2);
+
+  mb = CAL(BMP085_CAL_MB);
+  mc = CAL(BMP085_CAL_MC);
+  md = CAL(BMP085_CAL_MD);
+#undef CAL
 #if (BMP085_DEBUG == 1)
   Serial.print("ac1 = "); Serial.println(ac1, DEC);
   Serial.print("ac2 = "); Serial.println(ac2, DEC);
@@ -63,48 +130,218 @@ boolean Adafruit_BMP085::begin(uint8_t mode) {
   return true;
 }
 
+// Calibration words, then normal mode: no standby between measurements,
+// no IIR filter (the same response as a BMP085), the pressure oversampling
+// of the mode and x1 temperature.  The config register must be written
+// asleep, and the first results take a measurement.
+void Adafruit_BMP085::setup280(const uint8_t *cal) {
+  dig_T1 = le16(&cal[0]);
+  dig_T2 = le16(&cal[2]);
+  dig_T3 = le16(&cal[4]);
+  dig_P1 = le16(&cal[6]);
+  dig_P2 = le16(&cal[8]);
+  dig_P3 = le16(&cal[10]);
+  dig_P4 = le16(&cal[12]);
+  dig_P5 = le16(&cal[14]);
+  dig_P6 = le16(&cal[16]);
+  dig_P7 = le16(&cal[18]);
+  dig_P8 = le16(&cal[20]);
+  dig_P9 = le16(&cal[22]);
+
+  write8(BMP085_CONTROL, 0);
+  write8(BMP280_CONFIG, 0);
+  write8(BMP085_CONTROL, (1 << 5) | ((oversampling + 1) << 2) | 3);
+  bus->delay(pressureTime() / 1000 + 1);
+}
+
+uint8_t Adafruit_BMP085::getChipId(void) {
+  return chip;
+}
+
+void Adafruit_BMP085::getCalibration(BMP085_Calibration *cal) {
+  cal->ac1 = ac1; cal->ac2 = ac2; cal->ac3 = ac3;
+  cal->ac4 = ac4; cal->ac5 = ac5; cal->ac6 = ac6;
+  cal->b1 = b1; cal->b2 = b2;
+  cal->mb = mb; cal->mc = mc; cal->md = md;
+}
+
+void Adafruit_BMP085::setBus(Adafruit_BMP085_Bus *b) {
+  bus = b ? b : &wireBus;
+}
+
+Adafruit_BMP085_Bus *Adafruit_BMP085::getBus(void) {
+  return bus;
+}
+
+/*********************************************************************/
+
+void Adafruit_BMP085::setCalibrationCache(const char *dir) {
+  cacheDir = dir;
+}
+
+uint32_t Adafruit_BMP085::getCacheHits(void) {
+  return cacheHits;
+}
+
+uint32_t Adafruit_BMP085::getCacheMisses(void) {
+  return cacheMisses;
+}
+
+#ifdef BMP085_CACHE_FILES
+static uint16_t fletcher16(const uint8_t *p, uint8_t n) {
+  uint16_t a = 0, b = 0;
+  while (n--) {
+    a = (a + *p++) % 255;
+    b = (b + a) % 255;
+  }
+  return (b << 8) | a;
+}
+
+static void cachePath(char *path, size_t size, const char *dir) {
+  snprintf(path, size, "%s/bmp085-%02x.cal", dir, BMP085_I2CADDR);
+}
+#endif
+
+// The chip id was checked by begin(); AC5 and AC6 (dig_T1 and dig_T2 on a
+// BMP280), temperature coefficients, differ from chip to chip and are
+// read back to tell a replaced sensor, four bytes instead of 22
+boolean Adafruit_BMP085::loadCalibration(uint8_t *prom) {
+  if (!cacheDir) return false;
+#ifdef BMP085_CACHE_FILES
+  uint8_t f[CACHE_HEADER + 24 + 2], check[4];
+  uint8_t len = CACHE_HEADER + promBytes(chip);
+  uint8_t reg = (chip == BMP280_CHIPID) ? BMP280_CAL_T1 : BMP085_CAL_AC5;
+  char path[256];
+  cachePath(path, sizeof(path), cacheDir);
+  FILE *fp = fopen(path, "rb");
+  size_t n = 0;
+  if (fp) {
+    n = fread(f, 1, sizeof(f), fp);
+    fclose(fp);
+  }
+  if ((n == (size_t)len + 2) && !memcmp(f, "BMPC", 4) &&
+      (f[4] == CACHE_VERSION) && (f[5] == BMP085_I2CADDR) &&
+      (f[6] == chip) &&
+      (fletcher16(f, len) == (f[len] | (f[len+1] << 8))) &&
+      bus->readRegs(BMP085_I2CADDR, reg, check, 4) &&
+      !memcmp(check, &f[CACHE_HEADER + reg - promStart(chip)], 4)) {
+    memcpy(prom, &f[CACHE_HEADER], promBytes(chip));
+    cacheHits++;
+    return true;
+  }
+#endif
+  cacheMisses++;
+  return false;
+}
+
+// Written to a temporary and renamed, so a crash can't leave half a file
+void Adafruit_BMP085::storeCalibration(const uint8_t *prom) {
+  if (!cacheDir) return;
+#ifdef BMP085_CACHE_FILES
+  uint8_t f[CACHE_HEADER + 24 + 2];
+  uint8_t len = CACHE_HEADER + promBytes(chip);
+  char path[256], tmp[260];
+  memcpy(f, "BMPC", 4);
+  f[4] = CACHE_VERSION;
+  f[5] = BMP085_I2CADDR;
+  f[6] = chip;
+  f[7] = 0;
+  memcpy(&f[CACHE_HEADER], prom, promBytes(chip));
+  uint16_t sum = fletcher16(f, len);
+  f[len] = sum;
+  f[len+1] = sum >> 8;
+
+  cachePath(path, sizeof(path), cacheDir);
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE *fp = fopen(tmp, "wb");
+  if (!fp) return;
+  boolean ok = fwrite(f, 1, len + 2, fp) == (size_t)len + 2;
+  if (fclose(fp) != 0) ok = false;
+#ifdef _WIN32
+  if (ok) remove(path); // rename() won't replace it there
+#endif
+  if (!ok || (rename(tmp, path) != 0)) remove(tmp);
+#endif
+}
+
 int32_t Adafruit_BMP085::computeB5(int32_t UT) {
+  if (chip == BMP280_CHIPID)
+    return computeTFine280(UT);
   int32_t X1 = (UT - (int32_t)ac6) * ((int32_t)ac5) >> 15;
   int32_t X2 = ((int32_t)mc << 11) / (X1+(int32_t)md);
   return X1 + X2;
 }
 
+// B5 of a temperature just converted, remembered for readAll()
+int32_t Adafruit_BMP085::freshB5(int32_t UT) {
+  lastB5 = computeB5(UT);
+  b5Time = bus->millis();
+  b5Valid = true;
+  return lastB5;
+}
+
+// Temperature in *C and in 0.1 *C from B5 (t_fine); a BMP280 resolves
+// 0.01 *C
+float Adafruit_BMP085::celsius(int32_t B5) {
+  float temp;
+
+  if (chip == BMP280_CHIPID) {
+    temp = (B5 * 5 + 128) >> 8;
+    return temp / 100;
+  }
+  temp = (B5+8) >> 4;
+  return temp / 10;
+}
+
+int16_t Adafruit_BMP085::tenths(int32_t B5) {
+  if (chip == BMP280_CHIPID)
+    return (B5 + 256) >> 9;
+  return (B5+8) >> 4;
+}
+
 uint16_t Adafruit_BMP085::readRawTemperature(void) {
+  if (chip == BMP280_CHIPID)
+    return readTemperatureData() >> 4;
   write8(BMP085_CONTROL, BMP085_READTEMPCMD);
-  delay(5);
+  bus->delay(5);
 #if BMP085_DEBUG == 1
   Serial.print("Raw temp: "); Serial.println(read16(BMP085_TEMPDATA));
 #endif
-  return read16(BMP085_TEMPDATA);
+  return readTemperatureData();
 }
 
-uint32_t Adafruit_BMP085::readRawPressure(void) {
-  uint32_t raw;
-
-  write8(BMP085_CONTROL, BMP085_READPRESSURECMD + (oversampling << 6));
+// UT at full resolution: converted on a BMP085, the latest on a BMP280
+int32_t Adafruit_BMP085::rawTemperature(void) {
+  if (chip == BMP280_CHIPID)
+    return readTemperatureData();
+  return readRawTemperature();
+}
 
+// Pressure conversion time in microseconds for the oversampling mode.  On
+// a BMP280, the measurement period in normal mode: the datasheet's
+// maximum measurement time, 1.25 ms + 2.3 ms for the temperature sample
+// + 2.3 ms per pressure sample + 0.575 ms, and 0.5 ms standby.
+uint32_t Adafruit_BMP085::pressureTime(void) {
+  if (chip == BMP280_CHIPID)
+    return 4625 + (2300UL << oversampling);
   if (oversampling == BMP085_ULTRALOWPOWER) 
-    delay(5);
+    return 5000;
   else if (oversampling == BMP085_STANDARD) 
-    delay(8);
+    return 8000;
   else if (oversampling == BMP085_HIGHRES) 
-    delay(14);
+    return 14000;
   else 
-    delay(26);
-
-  raw = read16(BMP085_PRESSUREDATA);
+    return 26000;
+}
 
-  raw <<= 8;
-  raw |= read8(BMP085_PRESSUREDATA+2);
-  raw >>= (8 - oversampling);
+uint32_t Adafruit_BMP085::readRawPressure(void) {
+  uint32_t raw;
 
- /* this pull broke stuff, look at it later?
-  if (oversampling==0) {
-    raw <<= 8;
-    raw |= read8(BMP085_PRESSUREDATA+2);
-    raw >>= (8 - oversampling);
-  }
- */
+  if (chip == BMP280_CHIPID)
+    return readPressureData();
+  write8(BMP085_CONTROL, BMP085_READPRESSURECMD + (oversampling << 6));
+  bus->delay(pressureTime() / 1000);
+  raw = readPressureData();
 
 #if BMP085_DEBUG == 1
   Serial.print("Raw pressure: "); Serial.println(raw);
@@ -112,13 +349,50 @@ uint32_t Adafruit_BMP085::readRawPressure(void) {
   return raw;
 }
 
+uint32_t Adafruit_BMP085::readTemperatureData(void) {
+  uint8_t b[3];
+
+  if (chip != BMP280_CHIPID)
+    return read16(BMP085_TEMPDATA);
+  bus->readRegs(BMP085_I2CADDR, BMP280_TEMPDATA, b, 3);
+  return (((uint32_t)b[0] << 16) | ((uint32_t)b[1] << 8) | b[2]) >> 4;
+}
+
+// Fetch a finished pressure conversion, all three bytes in one transaction
+uint32_t Adafruit_BMP085::readPressureData(void) {
+  uint8_t b[3];
+  uint32_t raw;
+
+  if (chip == BMP280_CHIPID) {
+    bus->readRegs(BMP085_I2CADDR, BMP280_PRESSUREDATA, b, 3);
+    return (((uint32_t)b[0] << 16) | ((uint32_t)b[1] << 8) | b[2]) >> 4;
+  }
+  bus->readRegs(BMP085_I2CADDR, BMP085_PRESSUREDATA, b, 3);
+  raw = ((uint32_t)b[0] << 16) | ((uint32_t)b[1] << 8) | b[2];
+  raw >>= (8 - oversampling);
+  return raw;
+}
+
+// Pressure and temperature of the same BMP280 measurement: the chip holds
+// its result registers for the length of a burst read
+void Adafruit_BMP085::readBurst(int32_t *UT, int32_t *UP) {
+  uint8_t b[6];
+
+  bus->readRegs(BMP085_I2CADDR, BMP280_PRESSUREDATA, b, 6);
+  *UP = (((uint32_t)b[0] << 16) | ((uint32_t)b[1] << 8) | b[2]) >> 4;
+  *UT = (((uint32_t)b[3] << 16) | ((uint32_t)b[4] << 8) | b[5]) >> 4;
+}
+
 
 int32_t Adafruit_BMP085::readPressure(void) {
-  int32_t UT, UP, B3, B5, B6, X1, X2, X3, p;
-  uint32_t B4, B7;
+  int32_t UT, UP, B5;
 
-  UT = readRawTemperature();
-  UP = readRawPressure();
+  if (chip == BMP280_CHIPID) {
+    readBurst(&UT, &UP);
+  } else {
+    UT = readRawTemperature();
+    UP = readRawPressure();
+  }
 
 #if BMP085_DEBUG == 1
   // use datasheet numbers!
@@ -137,14 +411,22 @@ int32_t Adafruit_BMP085::readPressure(void) {
   oversampling = 0;
 #endif
 
-  B5 = computeB5(UT);
+  B5 = freshB5(UT);
 
 #if BMP085_DEBUG == 1
-  Serial.print("X1 = "); Serial.println(X1);
-  Serial.print("X2 = "); Serial.println(X2);
   Serial.print("B5 = "); Serial.println(B5);
 #endif
 
+  return computePressure(UP, B5);
+}
+
+int32_t Adafruit_BMP085::computePressure(int32_t UP, int32_t B5) {
+  int32_t B3, B6, X1, X2, X3, p;
+  uint32_t B4, B7;
+
+  if (chip == BMP280_CHIPID)
+    return computePressure280(UP, B5);
+
   // do pressure calcs
   B6 = B5 - 4000;
   X1 = ((int32_t)b2 * ( (B6 * B6)>>12 )) >> 11;
@@ -194,6 +476,38 @@ int32_t Adafruit_BMP085::readPressure(void) {
   return p;
 }
 
+// The BMP280 datasheet's integer compensation, the 64-bit one for
+// pressure (the 32-bit one is several Pa out), rounded to whole Pa.  Its
+// left shifts of signed values are written as multiplications.
+int32_t Adafruit_BMP085::computeTFine280(int32_t UT) {
+  int32_t var1, var2;
+
+  var1 = (((UT >> 3) - ((int32_t)dig_T1 * 2)) * ((int32_t)dig_T2)) >> 11;
+  var2 = (((((UT >> 4) - ((int32_t)dig_T1)) *
+    ((UT >> 4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
+  return var1 + var2;
+}
+
+int32_t Adafruit_BMP085::computePressure280(int32_t UP, int32_t tFine) {
+  int64_t var1, var2, p;
+
+  var1 = (int64_t)tFine - 128000;
+  var2 = var1 * var1 * (int64_t)dig_P6;
+  var2 = var2 + var1 * (int64_t)dig_P5 * 131072;
+  var2 = var2 + (int64_t)dig_P4 * ((int64_t)1 << 35);
+  var1 = ((var1 * var1 * (int64_t)dig_P3) >> 8) + var1 * (int64_t)dig_P2 * 4096;
+  var1 = ((((int64_t)1 << 47) + var1) * (int64_t)dig_P1) >> 33;
+  if (var1 == 0)
+    return 0; // No calibration; avoid dividing by zero
+
+  p = 1048576 - UP;
+  p = ((p * ((int64_t)1 << 31) - var2) * 3125) / var1;
+  var1 = ((int64_t)dig_P9 * (p >> 13) * (p >> 13)) >> 25;
+  var2 = ((int64_t)dig_P8 * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + (int64_t)dig_P7 * 16; // Pa in Q24.8
+  return (p + 128) >> 8;
+}
+
 int32_t Adafruit_BMP085::readSealevelPressure(float altitude_meters) {
   float pressure = readPressure();
   return (int32_t)(pressure / pow(1.0-altitude_meters/44330, 5.255));
@@ -201,9 +515,8 @@ int32_t Adafruit_BMP085::readSealevelPressure(float altitude_meters) {
 
 float Adafruit_BMP085::readTemperature(void) {
   int32_t UT, B5;     // following ds convention
-  float temp;
 
-  UT = readRawTemperature();
+  UT = rawTemperature();
 
 #if BMP085_DEBUG == 1
   // use datasheet numbers!
@@ -214,11 +527,8 @@ float Adafruit_BMP085::readTemperature(void) {
   md = 2868;
 #endif
 
-  B5 = computeB5(UT);
-  temp = (B5+8) >> 4;
-  temp /= 10;
-  
-  return temp;
+  B5 = freshB5(UT);
+  return celsius(B5);
 }
 
 float Adafruit_BMP085::readAltitude(float sealevelPressure) {
@@ -231,67 +541,339 @@ float Adafruit_BMP085::readAltitude(float sealevelPressure) {
   return altitude;
 }
 
+void Adafruit_BMP085::readAll(BMP085_Reading *r, float altitude_meters,
+  uint32_t maxTempAge) {
+  int32_t UT, UP, B5;
+
+  if (chip == BMP280_CHIPID) {
+    readBurst(&UT, &UP);
+    B5 = freshB5(UT);
+  } else {
+    if (maxTempAge && b5Valid && ((bus->millis() - b5Time) < maxTempAge))
+      B5 = lastB5;
+    else
+      B5 = freshB5(readRawTemperature());
+    UP = readRawPressure();
+  }
+
+  r->temperature = celsius(B5);
+  r->pressure = computePressure(UP, B5);
+
+  float pressure = r->pressure;
+  r->sealevelPressure = (int32_t)(pressure /
+    pow(1.0-altitude_meters/44330, 5.255));
+  r->altitude = 44330 * (1.0 - pow(pressure / 101325.0f, 0.1903));
+}
+
 
 /*********************************************************************/
 
-uint8_t Adafruit_BMP085::read8(uint8_t a) {
-  uint8_t ret;
+// (p / 101325)^0.1903 in Q30 for p = 512*i Pa, i = ALT_FIRST..ALT_FIRST+158
+// (297 to 1106 hPa)
+#define ALT_FIRST 58
+#define ALT_LAST  (ALT_FIRST + 158)
+static const uint32_t altitudeTable[159] PROGMEM = {
+   850092959,  852862875,  855595034,  858290568,  860950556,  863576029,
+   866167973,  868727329,  871254999,  873751848,  876218701,  878656354,
+   881065568,  883447072,  885801571,  888129739,  890432224,  892709652,
+   894962625,  897191720,  899397498,  901580495,  903741232,  905880208,
+   907997909,  910094800,  912171335,  914227948,  916265063,  918283088,
+   920282417,  922263435,  924226511,  926172004,  928100263,  930011625,
+   931906418,  933784959,  935647557,  937494510,  939326110,  941142639,
+   942944371,  944731573,  946504504,  948263416,  950008556,  951740161,
+   953458464,  955163691,  956856062,  958535793,  960203092,  961858163,
+   963501204,  965132410,  966751969,  968360066,  969956879,  971542585,
+   973117355,  974681356,  976234751,  977777700,  979310358,  980832877,
+   982345407,  983848092,  985341074,  986824493,  988298484,  989763181,
+   991218712,  992665206,  994102787,  995531576,  996951693,  998363255,
+   999766376, 1001161167, 1002547740, 1003926201, 1005296655, 1006659205,
+  1008013954, 1009360999, 1010700439, 1012032368, 1013356880, 1014674067,
+  1015984019, 1017286823, 1018582566, 1019871334, 1021153210, 1022428275,
+  1023696611, 1024958294, 1026213405, 1027462017, 1028704207, 1029940047,
+  1031169609, 1032392965, 1033610183, 1034821333, 1036026482, 1037225695,
+  1038419037, 1039606573, 1040788365, 1041964474, 1043134963, 1044299889,
+  1045459313, 1046613291, 1047761881, 1048905138, 1050043118, 1051175874,
+  1052303461, 1053425929, 1054543332, 1055655719, 1056763142, 1057865648,
+  1058963287, 1060056106, 1061144153, 1062227474, 1063306113, 1064380118,
+  1065449531, 1066514396, 1067574756, 1068630654, 1069682132, 1070729230,
+  1071771989, 1072810449, 1073844650, 1074874630, 1075900428, 1076922081,
+  1077939627, 1078953103, 1079962543, 1080967986, 1081969464, 1082967015,
+  1083960670, 1084950465, 1085936433, 1086918607, 1087897018, 1088871700,
+  1089842684, 1090810001, 1091773682
+};
+// (1 - h/44330)^-5.255 in Q25 for h = 4096*j cm, j = SEA_FIRST..SEA_LAST
+// (-532 to 5611 m)
+#define SEA_FIRST -13
+#define SEA_LAST  137
+static const uint32_t sealevelTable[151] PROGMEM = {
+    31513733,   31665364,   31817865,   31971241,   32125498,   32280642,
+    32436678,   32593613,   32751452,   32910202,   33069869,   33230459,
+    33391978,   33554432,   33717828,   33882172,   34047470,   34213728,
+    34380955,   34549154,   34718335,   34888502,   35059663,   35231824,
+    35404993,   35579176,   35754379,   35930611,   36107877,   36286186,
+    36465543,   36645957,   36827434,   37009982,   37193608,   37378320,
+    37564124,   37751029,   37939041,   38128170,   38318421,   38509804,
+    38702326,   38895994,   39090817,   39286802,   39483959,   39682294,
+    39881816,   40082533,   40284454,   40487587,   40691940,   40897522,
+    41104341,   41312407,   41521727,   41732311,   41944168,   42157306,
+    42371734,   42587462,   42804498,   43022853,   43242534,   43463552,
+    43685916,   43909635,   44134719,   44361178,   44589021,   44818259,
+    45048901,   45280957,   45514437,   45749352,   45985711,   46223525,
+    46462805,   46703560,   46945802,   47189541,   47434787,   47681552,
+    47929847,   48179682,   48431069,   48684018,   48938542,   49194651,
+    49452357,   49711672,   49972607,   50235173,   50499384,   50765250,
+    51032784,   51301997,   51572903,   51845514,   52119841,   52395898,
+    52673697,   52953250,   53234572,   53517675,   53802571,   54089274,
+    54377798,   54668155,   54960360,   55254426,   55550366,   55848195,
+    56147927,   56449575,   56753154,   57058679,   57366163,   57675622,
+    57987070,   58300521,   58615992,   58933496,   59253050,   59574668,
+    59898366,   60224160,   60552066,   60882099,   61214275,   61548610,
+    61885122,   62223825,   62564738,   62907875,   63253256,   63600896,
+    63950812,   64303022,   64657544,   65014395,   65373592,   65735154,
+    66099099,   66465444,   66834209,   67205412,   67579072,   67955207,
+    68333837
+};
+
+// (p / 101325)^0.1903 in Q30, p clamped to the table
+static int32_t altitudeRatio(int32_t p) {
+  if (p < 512L * ALT_FIRST) p = 512L * ALT_FIRST;
+  if (p >= 512L * ALT_LAST) p = 512L * ALT_LAST - 1;
+  int16_t i = (p >> 9) - ALT_FIRST;
+  int32_t a = readTable(altitudeTable, i), b = readTable(altitudeTable, i+1);
+  return a + (((b - a) * (p & 511)) >> 9);
+}
 
-  Wire.beginTransmission(BMP085_I2CADDR); // start transmission to device 
-#if (ARDUINO >= 100)
-  Wire.write(a); // sends register address to read from
-#else
-  Wire.send(a); // sends register address to read from
-#endif
-  Wire.endTransmission(); // end transmission
-  
-  Wire.beginTransmission(BMP085_I2CADDR); // start transmission to device 
-  Wire.requestFrom(BMP085_I2CADDR, 1);// send data n-bytes read
-#if (ARDUINO >= 100)
-  ret = Wire.read(); // receive DATA
-#else
-  ret = Wire.receive(); // receive DATA
-#endif
-  Wire.endTransmission(); // end transmission
+int32_t Adafruit_BMP085::altitudeFixed(int32_t pressure,
+  int32_t sealevelPressure) {
+  int32_t g = altitudeRatio(pressure), g0 = 1L << 30, m = 4433000;
 
-  return ret;
+  // 44330 m * (1 - g/g0); the standard atmosphere needs no division
+  if (sealevelPressure != 101325) {
+    g0 = altitudeRatio(sealevelPressure);
+    m = ((int64_t)4433000 << 30) / g0;
+  }
+  return ((int64_t)(g0 - g) * m + (1L << 29)) >> 30;
 }
 
-uint16_t Adafruit_BMP085::read16(uint8_t a) {
-  uint16_t ret;
+int32_t Adafruit_BMP085::sealevelPressureFixed(int32_t pressure,
+  int32_t altitude_cm) {
+  if (altitude_cm < 4096L * SEA_FIRST) altitude_cm = 4096L * SEA_FIRST;
+  if (altitude_cm >= 4096L * SEA_LAST) altitude_cm = 4096L * SEA_LAST - 1;
+  int32_t h = altitude_cm - 4096L * SEA_FIRST;
+  int16_t j = h >> 12;
+  int32_t a = readTable(sealevelTable, j), b = readTable(sealevelTable, j+1);
+  int32_t s = a + (((b - a) * (h & 4095)) >> 12);
 
-  Wire.beginTransmission(BMP085_I2CADDR); // start transmission to device 
-#if (ARDUINO >= 100)
-  Wire.write(a); // sends register address to read from
-#else
-  Wire.send(a); // sends register address to read from
-#endif
-  Wire.endTransmission(); // end transmission
-  
-  Wire.beginTransmission(BMP085_I2CADDR); // start transmission to device 
-  Wire.requestFrom(BMP085_I2CADDR, 2);// send data n-bytes read
-#if (ARDUINO >= 100)
-  ret = Wire.read(); // receive DATA
-  ret <<= 8;
-  ret |= Wire.read(); // receive DATA
-#else
-  ret = Wire.receive(); // receive DATA
-  ret <<= 8;
-  ret |= Wire.receive(); // receive DATA
-#endif
-  Wire.endTransmission(); // end transmission
+  return ((int64_t)pressure * s) >> 25; // Truncated, as readSealevelPressure()
+}
+
+int16_t Adafruit_BMP085::readTemperatureFixed(void) {
+  return tenths(freshB5(rawTemperature()));
+}
+
+int32_t Adafruit_BMP085::readSealevelPressureFixed(int32_t altitude_cm) {
+  return sealevelPressureFixed(readPressure(), altitude_cm);
+}
+
+int32_t Adafruit_BMP085::readAltitudeFixed(int32_t sealevelPressure) {
+  return altitudeFixed(readPressure(), sealevelPressure);
+}
+
+
+/*********************************************************************/
+
+void Adafruit_BMP085::setEOCPin(int8_t pin) {
+  eoc = pin;
+  if (eoc >= 0)
+    pinMode(eoc, INPUT);
+}
+
+void Adafruit_BMP085::startCommand(uint8_t cmd, uint32_t us) {
+  write8(BMP085_CONTROL, cmd);
+  started = bus->micros();
+  wait = us;
+  eocLow = false;
+}
+
+// EOC drops while the chip converts and rises when it's done; only trust
+// a high level after seeing it low, and fall back on the datasheet time
+// in case poll() wasn't called while it was low
+boolean Adafruit_BMP085::conversionDone(void) {
+  if (eoc >= 0) {
+    if (digitalRead(eoc) == LOW)
+      eocLow = true;
+    else if (eocLow)
+      return true;
+  }
+  return (bus->micros() - started) >= wait;
+}
+
+// Returns false if a conversion is already running
+boolean Adafruit_BMP085::startConversion(void) {
+  if ((state == BMP085_CONVERT_T) || (state == BMP085_CONVERT_P))
+    return false;
+  if (chip == BMP280_CHIPID) {
+    readBurst(&rawT, &rawP); // Always converting; nothing to wait for
+    state = BMP085_DONE;
+    return true;
+  }
+  startCommand(BMP085_READTEMPCMD, 5000);
+  state = BMP085_CONVERT_T;
+  return true;
+}
+
+boolean Adafruit_BMP085::poll(void) {
+  // Only continuous mode leaves a BMP280 converting: a burst per period
+  if ((chip == BMP280_CHIPID) && (state == BMP085_CONVERT_P)) {
+    if ((bus->micros() - started) >= wait) {
+      started = bus->micros();
+      wait = pressureTime();
+      readBurst(&rawT, &rawP);
+      pushSample(started, computePressure(rawP, freshB5(rawT)));
+    }
+    return getSamplesAvailable() > 0;
+  }
+  if ((state == BMP085_CONVERT_T) && conversionDone()) {
+    rawT = readTemperatureData();
+    if (continuous) freshB5(rawT);
+    startCommand(BMP085_READPRESSURECMD + (oversampling << 6), pressureTime());
+    state = BMP085_CONVERT_P;
+  }
+  if ((state == BMP085_CONVERT_P) && conversionDone()) {
+    rawP = readPressureData();
+    if (!continuous) {
+      state = BMP085_DONE;
+    } else {
+      uint32_t stamp = started;
+      // Next conversion first, compensation while it runs
+      if (++sincePressure >= pressures) {
+        sincePressure = 0;
+        startCommand(BMP085_READTEMPCMD, 5000);
+        state = BMP085_CONVERT_T;
+      } else {
+        startCommand(BMP085_READPRESSURECMD + (oversampling << 6),
+          pressureTime());
+      }
+      pushSample(stamp, computePressure(rawP, lastB5));
+    }
+  }
+  if (continuous)
+    return getSamplesAvailable() > 0;
+  return state == BMP085_DONE;
+}
+
+// Compensate the raw values of a finished conversion (either pointer may
+// be NULL) and go back to idle.  False if poll() hasn't reported them yet.
+boolean Adafruit_BMP085::collect(float *temperature, int32_t *pressure) {
+  if (state != BMP085_DONE)
+    return false;
+  int32_t B5 = freshB5(rawT);
+  if (temperature)
+    *temperature = celsius(B5);
+  if (pressure)
+    *pressure = computePressure(rawP, B5);
+  state = BMP085_IDLE;
+  return true;
+}
+
+uint8_t Adafruit_BMP085::getState(void) {
+  return state;
+}
+
+// Starts with a temperature conversion, for the first samples' B5.  False
+// if a single conversion is running.
+boolean Adafruit_BMP085::startContinuous(uint8_t p) {
+  if (!continuous &&
+      ((state == BMP085_CONVERT_T) || (state == BMP085_CONVERT_P)))
+    return false;
+  pressures = p ? p : 1;
+  sincePressure = 0;
+  ringHead = ringTail = 0;
+  drops = rate = rateCount = 0;
+  rateStart = bus->micros();
+  continuous = true;
+  if (chip == BMP280_CHIPID) {
+    started = rateStart;
+    wait = 0; // The first sample is already there
+    state = BMP085_CONVERT_P;
+    return true;
+  }
+  startCommand(BMP085_READTEMPCMD, 5000);
+  state = BMP085_CONVERT_T;
+  return true;
+}
+
+// The conversion running is left to finish; its result isn't read
+void Adafruit_BMP085::stopContinuous(void) {
+  continuous = false;
+  state = BMP085_IDLE;
+}
+
+// Single producer (poll()), single consumer (readSample()): each side
+// writes only its own index, and publishes it after the slot it covers
+void Adafruit_BMP085::pushSample(uint32_t stamp, int32_t pressure) {
+  uint8_t head = ringHead;
+
+  rateCount++;
+  if ((stamp - rateStart) >= 1000000UL) {
+    __atomic_store_n(&rate,
+      (uint32_t)((uint64_t)rateCount * 1000000000UL / (stamp - rateStart)),
+      __ATOMIC_RELAXED);
+    rateStart = stamp;
+    rateCount = 0;
+  }
 
+  if ((uint8_t)(head - __atomic_load_n(&ringTail, __ATOMIC_ACQUIRE)) >=
+      BMP085_RING_SIZE) {
+    __atomic_store_n(&drops, drops + 1, __ATOMIC_RELAXED);
+    return;
+  }
+  BMP085_Sample *s = &ring[head & (BMP085_RING_SIZE - 1)];
+  s->micros = stamp;
+  s->pressure = pressure;
+  s->temperature = tenths(lastB5);
+  __atomic_store_n(&ringHead, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+}
+
+boolean Adafruit_BMP085::readSample(BMP085_Sample *s) {
+  uint8_t tail = ringTail;
+
+  if (__atomic_load_n(&ringHead, __ATOMIC_ACQUIRE) == tail)
+    return false;
+  *s = ring[tail & (BMP085_RING_SIZE - 1)];
+  __atomic_store_n(&ringTail, (uint8_t)(tail + 1), __ATOMIC_RELEASE);
+  return true;
+}
+
+uint8_t Adafruit_BMP085::getSamplesAvailable(void) {
+  return __atomic_load_n(&ringHead, __ATOMIC_ACQUIRE) -
+    __atomic_load_n(&ringTail, __ATOMIC_ACQUIRE);
+}
+
+float Adafruit_BMP085::getSampleRate(void) {
+  return __atomic_load_n(&rate, __ATOMIC_RELAXED) / 1000.0;
+}
+
+uint32_t Adafruit_BMP085::getDrops(void) {
+  return __atomic_load_n(&drops, __ATOMIC_RELAXED);
+}
+
+/*********************************************************************/
+
+uint8_t Adafruit_BMP085::read8(uint8_t a) {
+  uint8_t ret = 0;
+
+  bus->readRegs(BMP085_I2CADDR, a, &ret, 1);
   return ret;
 }
 
+uint16_t Adafruit_BMP085::read16(uint8_t a) {
+  uint8_t b[2] = { 0, 0 };
+
+  bus->readRegs(BMP085_I2CADDR, a, b, 2);
+  return be16(b);
+}
+
 void Adafruit_BMP085::write8(uint8_t a, uint8_t d) {
-  Wire.beginTransmission(BMP085_I2CADDR); // start transmission to device 
-#if (ARDUINO >= 100)
-  Wire.write(a); // sends register address to read from
-  Wire.write(d);  // write data
-#else
-  Wire.send(a); // sends register address to read from
-  Wire.send(d);  // write data
-#endif
-  Wire.endTransmission(); // end transmission
+  bus->writeReg(BMP085_I2CADDR, a, d);
 }
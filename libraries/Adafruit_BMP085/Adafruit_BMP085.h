@@ -24,6 +24,7 @@
  #include "WProgram.h"
 #endif
 #include "Wire.h"
+#include "Adafruit_BMP085_Bus.h"
 
 #define BMP085_DEBUG 0
 
@@ -51,28 +52,201 @@
 #define BMP085_READTEMPCMD          0x2E
 #define BMP085_READPRESSURECMD            0x34
 
+// Chip ids at 0xD0; the BMP180 answers as a BMP085
+#define BMP085_CHIPID            0x55
+#define BMP280_CHIPID            0x58
 
+#define BMP280_CAL_T1            0x88  // R   Calibration data (12 words, LE)
+#define BMP280_CONFIG            0xF5  // RW  Standby time, IIR filter
+#define BMP280_PRESSUREDATA      0xF7  // R   20 bits, then temperature
+#define BMP280_TEMPDATA          0xFA  // R   20 bits
+
+// Conversion states of the non-blocking interface
+#define BMP085_IDLE              0 // Nothing started, or results collected
+#define BMP085_CONVERT_T         1 // Temperature conversion running
+#define BMP085_CONVERT_P         2 // Pressure conversion running
+#define BMP085_DONE              3 // Raw results in, ready to collect()
+
+// Everything one readAll() measures
+typedef struct {
+  float   temperature;      // *C
+  int32_t pressure;         // Pa
+  int32_t sealevelPressure; // Pa, reduced from the altitude given
+  float   altitude;         // m, against the standard atmosphere
+} BMP085_Reading;
+
+// The calibration PROM, as getCalibration() returns it
+typedef struct {
+  int16_t  ac1, ac2, ac3;
+  uint16_t ac4, ac5, ac6;
+  int16_t  b1, b2, mb, mc, md;
+} BMP085_Calibration;
+
+// One sample of continuous acquisition
+typedef struct {
+  uint32_t micros;      // When its pressure conversion started
+  int32_t  pressure;    // Pa
+  int16_t  temperature; // 0.1 *C, from the latest temperature conversion
+} BMP085_Sample;
+
+// Samples the continuous mode buffers, a power of two up to 128
+#ifndef BMP085_RING_SIZE
+ #ifdef __AVR__
+  #define BMP085_RING_SIZE 8
+ #else
+  #define BMP085_RING_SIZE 64
+ #endif
+#endif
+
+// The BMP085, the BMP180 and the BMP280, told apart by begin() from the
+// chip id.  A BMP280 runs in normal mode, measuring on its own at the
+// oversampling the mode gives (x1, x2, x4 or x8 pressure, like the
+// BMP085), so a read is a single burst of the latest results without
+// waiting for a conversion.  Every function below works on either, unless
+// it says otherwise.
 class Adafruit_BMP085 {
  public:
   Adafruit_BMP085();
   boolean begin(uint8_t mode = BMP085_ULTRAHIGHRES);  // by default go highres
+  void setBus(Adafruit_BMP085_Bus *bus); // Before begin(); default Wire
+  Adafruit_BMP085_Bus *getBus(void);      // Also the driver's clock
+  uint8_t getChipId(void);  // BMP085_CHIPID or BMP280_CHIPID after begin()
   float readTemperature(void);
   int32_t readPressure(void);
   int32_t readSealevelPressure(float altitude_meters = 0);
   float readAltitude(float sealevelPressure = 101325); // std atmosphere
-  uint16_t readRawTemperature(void);
+  uint16_t readRawTemperature(void);  // BMP280: the top 16 of 20 bits
   uint32_t readRawPressure(void);
+
+  // One temperature and one pressure conversion for all four values,
+  // where calling the functions above would convert temperature for each.
+  // If a temperature was converted less than maxTempAge ms ago (by any
+  // read), its B5 is reused and only pressure is converted; 0 always
+  // converts both.  A BMP280 always reads both, in one burst.
+  void readAll(BMP085_Reading *r, float altitude_meters = 0,
+    uint32_t maxTempAge = 0);
+
+  // Integer-only counterparts of the read functions, for hosts where float
+  // division and pow() are slow: temperature in 0.1 *C, altitude in cm,
+  // pressure in Pa.  Altitude and sea-level reduction interpolate tables
+  // of the same formulas.  Against the float functions, over 300-1100 hPa:
+  // temperature is exact; sea-level pressure within 1 Pa for altitudes of
+  // -530 to 5600 m (beyond, the altitude is clamped); altitude within
+  // 5 cm above 700 hPa (about 3000 m) and 20 cm down to 300 hPa.  The
+  // static ones work on a pressure from anywhere, e.g. collect().
+  int16_t readTemperatureFixed(void);
+  int32_t readSealevelPressureFixed(int32_t altitude_cm = 0);
+  int32_t readAltitudeFixed(int32_t sealevelPressure = 101325);
+  static int32_t sealevelPressureFixed(int32_t pressure, int32_t altitude_cm);
+  static int32_t altitudeFixed(int32_t pressure,
+    int32_t sealevelPressure = 101325);
+
+  // Raw samples logged for later: keep getCalibration() and the
+  // oversampling mode with them, and compensate() turns n raw (UT, UP)
+  // pairs into temperatures (0.1 *C; may be NULL) and pressures (Pa),
+  // bit-exact with readTemperature() and readPressure().  Uses SSE2 or
+  // NEON where the compiler targets them (Adafruit_BMP085_Batch.cpp;
+  // examples_rpi/BMP085/compensateCheck.cpp checks them against the
+  // scalar path).  BMP085 and BMP180 only.
+  void getCalibration(BMP085_Calibration *cal);
+  static void compensate(const BMP085_Calibration *cal, uint8_t oversampling,
+    const uint16_t *UT, const uint32_t *UP, int16_t *temperature,
+    int32_t *pressure, uint32_t n);
+
+  // The calibration PROM is set at the factory, so begin() can take it
+  // from a file in 'dir' (one per device address, kept by the caller)
+  // rather than the bus.  The file is used when its checksum holds and
+  // the chip id and two coefficients read back from the chip agree;
+  // otherwise the PROM is read and the file rewritten.  Files need a
+  // hosted C library (Linux, macOS, Windows); elsewhere it's always a miss.
+  void setCalibrationCache(const char *dir);
+  uint32_t getCacheHits(void);
+  uint32_t getCacheMisses(void);
+
+  // Non-blocking reads.  startConversion() starts a temperature and then a
+  // pressure conversion and returns; poll() moves things along without
+  // waiting (call it from loop()) and returns true once both raw values
+  // are in; collect() then compensates them.  Readiness comes from the
+  // datasheet conversion times, or sooner from the EOC pin if it is wired
+  // up and given to setEOCPin().  On a BMP280 startConversion() reads the
+  // latest results, and poll() is true straight away.
+  void    setEOCPin(int8_t pin);
+  boolean startConversion(void);
+  boolean poll(void);
+  boolean collect(float *temperature, int32_t *pressure);
+  uint8_t getState(void);
+
+  // Continuous acquisition: poll() starts each conversion as soon as the
+  // previous one is read, a temperature after every 'pressures' pressure
+  // conversions, and queues a sample per pressure.  Call poll() often
+  // (the fastest mode converts every 5 ms, or as soon as EOC rises) and
+  // drain with readSample(), from the same thread or, as a single
+  // producer and single consumer, from two.  A sample that finds the
+  // queue full is dropped and counted.  getSampleRate() is samples per
+  // second over the last second or so, drops included.  The other reads
+  // must wait for stopContinuous().  On a BMP280 poll() reads a sample
+  // per measurement period of the chip, stamped with the time it read it.
+  boolean  startContinuous(uint8_t pressures = 16);
+  void     stopContinuous(void);
+  boolean  readSample(BMP085_Sample *s);
+  uint8_t  getSamplesAvailable(void);
+  float    getSampleRate(void);
+  uint32_t getDrops(void);
   
+
  private:
+  boolean loadCalibration(uint8_t *prom);
+  void storeCalibration(const uint8_t *prom);
+  void setup280(const uint8_t *prom);
   int32_t computeB5(int32_t UT);
+  int32_t freshB5(int32_t UT);
+  int32_t computePressure(int32_t UP, int32_t B5);
+  int32_t computeTFine280(int32_t UT);
+  int32_t computePressure280(int32_t UP, int32_t tFine);
+  float   celsius(int32_t B5);
+  int16_t tenths(int32_t B5);
+  uint32_t pressureTime(void);
+  int32_t rawTemperature(void);
+  uint32_t readTemperatureData(void);
+  uint32_t readPressureData(void);
+  void readBurst(int32_t *UT, int32_t *UP);
+  boolean conversionDone(void);
+  void startCommand(uint8_t cmd, uint32_t us);
+  void pushSample(uint32_t stamp, int32_t pressure);
   uint8_t read8(uint8_t addr);
   uint16_t read16(uint8_t addr);
   void write8(uint8_t addr, uint8_t data);
 
+  Adafruit_BMP085_Bus *bus;
+  const char *cacheDir;
+  uint32_t cacheHits, cacheMisses;
+  uint8_t chip;
   uint8_t oversampling;
 
+  uint8_t  state;
+  int8_t   eoc;           // EOC pin, -1 if not wired
+  boolean  eocLow;        // EOC seen low since the command
+  uint32_t started, wait; // micros() at the command, conversion time
+  int32_t  rawT, rawP;
+
+  boolean  continuous;
+  uint8_t  pressures, sincePressure; // Pressures per temperature, and since
+  BMP085_Sample ring[BMP085_RING_SIZE];
+  uint8_t  ringHead, ringTail;       // Written by poll(), by readSample()
+  uint32_t drops, rate;              // rate in samples per 1000 s
+  uint32_t rateStart, rateCount;
+
+  // On a BMP280, B5 stands for t_fine, which plays the same part
+  boolean  b5Valid;       // lastB5 is from a conversion at b5Time (millis())
+  int32_t  lastB5;
+  uint32_t b5Time;
+
   int16_t ac1, ac2, ac3, b1, b2, mb, mc, md;
   uint16_t ac4, ac5, ac6;
+
+  uint16_t dig_T1, dig_P1;
+  int16_t  dig_T2, dig_T3, dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7,
+    dig_P8, dig_P9;
 };
 
 
@@ -0,0 +1,227 @@
+/***************************************************
+  Batch compensation of logged raw BMP085 samples, structure of arrays,
+  with SSE2 and NEON paths.  Each step follows computeB5() and
+  computePressure() in Adafruit_BMP085.cpp operation for operation
+  (32-bit wrapping arithmetic, the same shifts and truncating divisions),
+  so the results are bit-exact with the driver.
+ ****************************************************/
+
+#include "Adafruit_BMP085.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define BMP085_NEON
+#elif defined(__SSE2__)
+ #include <emmintrin.h>
+ #define BMP085_SSE2
+#endif
+
+static void compensateOne(const BMP085_Calibration *c, uint8_t oss,
+  int32_t UT, int32_t UP, int16_t *temperature, int32_t *pressure) {
+  int32_t B3, B5, B6, X1, X2, X3, p;
+  uint32_t B4, B7;
+
+  X1 = (UT - (int32_t)c->ac6) * ((int32_t)c->ac5) >> 15;
+  X2 = ((int32_t)c->mc << 11) / (X1+(int32_t)c->md);
+  B5 = X1 + X2;
+  if (temperature) *temperature = (B5+8) >> 4;
+
+  B6 = B5 - 4000;
+  X1 = ((int32_t)c->b2 * ( (B6 * B6)>>12 )) >> 11;
+  X2 = ((int32_t)c->ac2 * B6) >> 11;
+  X3 = X1 + X2;
+  B3 = ((((int32_t)c->ac1*4 + X3) << oss) + 2) / 4;
+  X1 = ((int32_t)c->ac3 * B6) >> 13;
+  X2 = ((int32_t)c->b1 * ((B6 * B6) >> 12)) >> 16;
+  X3 = ((X1 + X2) + 2) >> 2;
+  B4 = ((uint32_t)c->ac4 * (uint32_t)(X3 + 32768)) >> 15;
+  B7 = ((uint32_t)UP - B3) * (uint32_t)( 50000UL >> oss );
+  if (B7 < 0x80000000) {
+    p = (B7 * 2) / B4;
+  } else {
+    p = (B7 / B4) * 2;
+  }
+  X1 = (p >> 8) * (p >> 8);
+  X1 = (X1 * 3038) >> 16;
+  X2 = (-7357 * p) >> 16;
+  *pressure = p + ((X1 + X2 + (int32_t)3791)>>4);
+}
+
+#if defined(BMP085_SSE2)
+
+// Low 32 bits of the products, the same for signed and unsigned
+static inline __m128i mullo(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b),
+          odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+// Truncating division through doubles, exact for 32-bit operands: a
+// non-integer quotient is at least 1/|b| from an integer, more than its
+// rounding error
+static inline __m128i div32(__m128d alo, __m128d ahi, __m128i b) {
+  __m128d blo = _mm_cvtepi32_pd(b),
+          bhi = _mm_cvtepi32_pd(_mm_shuffle_epi32(b, _MM_SHUFFLE(1,0,3,2)));
+  return _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_div_pd(alo, blo)),
+    _mm_cvttpd_epi32(_mm_div_pd(ahi, bhi)));
+}
+
+// Low two lanes, unsigned, to double via the signed conversion
+static inline __m128d cvtu32(__m128i a) {
+  return _mm_add_pd(_mm_cvtepi32_pd(_mm_xor_si128(a,
+    _mm_set1_epi32(0x80000000))), _mm_set1_pd(2147483648.0));
+}
+
+#elif defined(BMP085_NEON)
+
+// Truncating unsigned division, b < 2^31: a float estimate, a second
+// one of what the remainder still holds, then one correction either way.
+// The first estimate is good to about 2^-21 of the quotient, so its
+// remainder is below 2^11 in magnitude, converts to float exactly and
+// leaves the second estimate less than one off.  Exact for every a:
+// temperatures with UT far from the calibration point have quotients up
+// to 2^26, well past what one correction covers.
+static inline uint32x4_t udiv32(uint32x4_t a, uint32x4_t b) {
+  float32x4_t bf = vcvtq_f32_u32(b), r = vrecpeq_f32(bf);
+  r = vmulq_f32(r, vrecpsq_f32(bf, r));
+  r = vmulq_f32(r, vrecpsq_f32(bf, r));
+  uint32x4_t q   = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(a), r));
+  int32x4_t  rem = vreinterpretq_s32_u32(vsubq_u32(a, vmulq_u32(q, b)));
+  q   = vaddq_u32(q, vreinterpretq_u32_s32(vcvtq_s32_f32(
+    vmulq_f32(vcvtq_f32_s32(rem), r))));
+  rem = vreinterpretq_s32_u32(vsubq_u32(a, vmulq_u32(q, b)));
+  uint32x4_t lo  = vcltq_s32(rem, vdupq_n_s32(0)),
+             hi  = vcgeq_s32(rem, vreinterpretq_s32_u32(b));
+  // Masks are all ones (-1) where true
+  return vsubq_u32(vaddq_u32(q, lo), hi);
+}
+
+#endif
+
+void Adafruit_BMP085::compensate(const BMP085_Calibration *cal,
+  uint8_t oversampling, const uint16_t *UT, const uint32_t *UP,
+  int16_t *temperature, int32_t *pressure, uint32_t n) {
+  uint8_t  oss = oversampling > BMP085_ULTRAHIGHRES ?
+    BMP085_ULTRAHIGHRES : oversampling;
+  uint32_t i = 0;
+
+#if defined(BMP085_SSE2)
+  const __m128i ac1 = _mm_set1_epi32(cal->ac1), ac2 = _mm_set1_epi32(cal->ac2),
+    ac3 = _mm_set1_epi32(cal->ac3), ac4 = _mm_set1_epi32(cal->ac4),
+    ac5 = _mm_set1_epi32(cal->ac5), ac6 = _mm_set1_epi32(cal->ac6),
+    b1 = _mm_set1_epi32(cal->b1), b2 = _mm_set1_epi32(cal->b2),
+    md = _mm_set1_epi32(cal->md), zero = _mm_setzero_si128(),
+    c3 = _mm_set1_epi32(3),
+    scale = _mm_set1_epi32(50000UL >> oss), shift = _mm_cvtsi32_si128(oss);
+  const __m128d mc = _mm_set1_pd((double)((int32_t)cal->mc << 11));
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i ut = _mm_unpacklo_epi16(
+      _mm_loadl_epi64((const __m128i *)&UT[i]), zero);
+    __m128i up = _mm_loadu_si128((const __m128i *)&UP[i]);
+
+    __m128i x1 = _mm_srai_epi32(mullo(_mm_sub_epi32(ut, ac6), ac5), 15);
+    __m128i x2 = div32(mc, mc, _mm_add_epi32(x1, md));
+    __m128i b5 = _mm_add_epi32(x1, x2);
+    if (temperature) {
+      // Keep the low halves, as a cast would (packs would saturate)
+      __m128i t = _mm_srai_epi32(_mm_add_epi32(b5, _mm_set1_epi32(8)), 4);
+      t = _mm_srai_epi32(_mm_slli_epi32(t, 16), 16);
+      _mm_storel_epi64((__m128i *)&temperature[i], _mm_packs_epi32(t, t));
+    }
+
+    __m128i b6  = _mm_sub_epi32(b5, _mm_set1_epi32(4000));
+    __m128i b66 = _mm_srai_epi32(mullo(b6, b6), 12);
+    x1 = _mm_srai_epi32(mullo(b2, b66), 11);
+    x2 = _mm_srai_epi32(mullo(ac2, b6), 11);
+    __m128i b3 = _mm_add_epi32(
+      _mm_sll_epi32(_mm_add_epi32(_mm_slli_epi32(ac1, 2),
+        _mm_add_epi32(x1, x2)), shift), _mm_set1_epi32(2));
+    b3 = _mm_srai_epi32(_mm_add_epi32(b3,  // Division by 4 rounds to zero
+      _mm_and_si128(_mm_srai_epi32(b3, 31), c3)), 2);
+    x1 = _mm_srai_epi32(mullo(ac3, b6), 13);
+    x2 = _mm_srai_epi32(mullo(b1, b66), 16);
+    __m128i x3 = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(x1, x2),
+      _mm_set1_epi32(2)), 2);
+    __m128i b4 = _mm_srli_epi32(mullo(ac4,
+      _mm_add_epi32(x3, _mm_set1_epi32(32768))), 15);
+    __m128i b7 = mullo(_mm_sub_epi32(up, b3), scale);
+
+    // B7 < 2^31: (B7 * 2) / B4, else (B7 / B4) * 2
+    __m128i big = _mm_srai_epi32(b7, 31);
+    __m128i num = _mm_or_si128(_mm_and_si128(big, b7),
+      _mm_andnot_si128(big, _mm_add_epi32(b7, b7)));
+    __m128i p   = div32(cvtu32(num),
+      cvtu32(_mm_shuffle_epi32(num, _MM_SHUFFLE(1,0,3,2))), b4);
+    p = _mm_add_epi32(p, _mm_and_si128(big, p));
+
+    __m128i p8 = _mm_srai_epi32(p, 8);
+    x1 = _mm_srai_epi32(mullo(mullo(p8, p8), _mm_set1_epi32(3038)), 16);
+    x2 = _mm_srai_epi32(mullo(p, _mm_set1_epi32(-7357)), 16);
+    p  = _mm_add_epi32(p, _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(x1, x2),
+      _mm_set1_epi32(3791)), 4));
+    _mm_storeu_si128((__m128i *)&pressure[i], p);
+  }
+#elif defined(BMP085_NEON)
+  const int32x4_t ac1 = vdupq_n_s32(cal->ac1), ac2 = vdupq_n_s32(cal->ac2),
+    ac3 = vdupq_n_s32(cal->ac3), ac6 = vdupq_n_s32(cal->ac6),
+    ac5 = vdupq_n_s32(cal->ac5), b1 = vdupq_n_s32(cal->b1),
+    b2 = vdupq_n_s32(cal->b2), md = vdupq_n_s32(cal->md),
+    shift = vdupq_n_s32(oss);
+  const uint32x4_t ac4 = vdupq_n_u32(cal->ac4),
+    scale = vdupq_n_u32(50000UL >> oss);
+  const int32_t  mc = (int32_t)cal->mc << 11;
+  const uint32_t mcAbs = mc < 0 ? -(uint32_t)mc : mc;
+
+  for (; i + 4 <= n; i += 4) {
+    int32x4_t ut = vreinterpretq_s32_u32(vmovl_u16(vld1_u16(&UT[i])));
+    uint32x4_t up = vld1q_u32(&UP[i]);
+
+    int32x4_t x1 = vshrq_n_s32(vmulq_s32(vsubq_s32(ut, ac6), ac5), 15);
+    // Signed division as magnitudes, negated where the signs differ
+    int32x4_t den = vaddq_s32(x1, md);
+    int32x4_t neg = vshrq_n_s32(veorq_s32(den, vdupq_n_s32(mc)), 31);
+    int32x4_t x2  = vreinterpretq_s32_u32(udiv32(vdupq_n_u32(mcAbs),
+      vreinterpretq_u32_s32(vabsq_s32(den))));
+    x2 = vsubq_s32(veorq_s32(x2, neg), neg);
+    int32x4_t b5 = vaddq_s32(x1, x2);
+    if (temperature)
+      vst1_s16(&temperature[i], vmovn_s32(vshrq_n_s32(
+        vaddq_s32(b5, vdupq_n_s32(8)), 4)));
+
+    int32x4_t b6  = vsubq_s32(b5, vdupq_n_s32(4000));
+    int32x4_t b66 = vshrq_n_s32(vmulq_s32(b6, b6), 12);
+    x1 = vshrq_n_s32(vmulq_s32(b2, b66), 11);
+    x2 = vshrq_n_s32(vmulq_s32(ac2, b6), 11);
+    int32x4_t b3 = vaddq_s32(vshlq_s32(vaddq_s32(vshlq_n_s32(ac1, 2),
+      vaddq_s32(x1, x2)), shift), vdupq_n_s32(2));
+    b3 = vshrq_n_s32(vaddq_s32(b3,  // Division by 4 rounds to zero
+      vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(
+        vshrq_n_s32(b3, 31)), 30))), 2);
+    x1 = vshrq_n_s32(vmulq_s32(ac3, b6), 13);
+    x2 = vshrq_n_s32(vmulq_s32(b1, b66), 16);
+    int32x4_t x3 = vshrq_n_s32(vaddq_s32(vaddq_s32(x1, x2), vdupq_n_s32(2)), 2);
+    uint32x4_t b4 = vshrq_n_u32(vmulq_u32(ac4, vreinterpretq_u32_s32(
+      vaddq_s32(x3, vdupq_n_s32(32768)))), 15);
+    uint32x4_t b7 = vmulq_u32(vsubq_u32(up, vreinterpretq_u32_s32(b3)), scale);
+
+    // B7 < 2^31: (B7 * 2) / B4, else (B7 / B4) * 2
+    uint32x4_t big = vreinterpretq_u32_s32(
+      vshrq_n_s32(vreinterpretq_s32_u32(b7), 31));
+    uint32x4_t q = udiv32(vbslq_u32(big, b7, vaddq_u32(b7, b7)), b4);
+    int32x4_t  p = vreinterpretq_s32_u32(vaddq_u32(q, vandq_u32(big, q)));
+
+    int32x4_t p8 = vshrq_n_s32(p, 8);
+    x1 = vshrq_n_s32(vmulq_s32(vmulq_s32(p8, p8), vdupq_n_s32(3038)), 16);
+    x2 = vshrq_n_s32(vmulq_s32(p, vdupq_n_s32(-7357)), 16);
+    p  = vaddq_s32(p, vshrq_n_s32(vaddq_s32(vaddq_s32(x1, x2),
+      vdupq_n_s32(3791)), 4));
+    vst1q_s32(&pressure[i], p);
+  }
+#endif
+
+  for (; i < n; i++)
+    compensateOne(cal, oss, UT[i], UP[i], temperature ? &temperature[i] : NULL,
+      &pressure[i]);
+}
@@ -0,0 +1,118 @@
+/***************************************************
+  I2C transports for the BMP085 driver: Arduino Wire and Linux i2c-dev.
+  See Adafruit_BMP085_Bus.h.
+ ****************************************************/
+
+#include "Adafruit_BMP085_Bus.h"
+#include "Wire.h"
+
+#if defined(__linux__)
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/ioctl.h>
+ #include <linux/i2c.h>
+ #include <linux/i2c-dev.h>
+#endif
+
+boolean Adafruit_BMP085_Bus::readRegs(uint8_t addr, uint8_t reg, uint8_t *buf,
+  uint8_t len) {
+  return transfer(addr, &reg, 1, buf, len);
+}
+
+boolean Adafruit_BMP085_Bus::writeReg(uint8_t addr, uint8_t reg,
+  uint8_t value) {
+  uint8_t b[2] = { reg, value };
+  return transfer(addr, b, 2, NULL, 0);
+}
+
+/*********************************************************************/
+
+boolean Adafruit_BMP085_WireBus::begin(void) {
+  Wire.begin();
+  return true;
+}
+
+boolean Adafruit_BMP085_WireBus::transfer(uint8_t addr, const uint8_t *wbuf,
+  uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  if (wlen) {
+    Wire.beginTransmission(addr);
+#if (ARDUINO >= 100)
+    Wire.write(wbuf, wlen);
+    // No stop before a read: it follows with a repeated start
+    if (Wire.endTransmission(rlen == 0) != 0) return false;
+#else
+    for (uint8_t i=0; i<wlen; i++) Wire.send(wbuf[i]);
+    if (Wire.endTransmission() != 0) return false;
+#endif
+  }
+  if (rlen) {
+    if (Wire.requestFrom(addr, rlen) != rlen) return false;
+    for (uint8_t i=0; i<rlen; i++) {
+#if (ARDUINO >= 100)
+      rbuf[i] = Wire.read();
+#else
+      rbuf[i] = Wire.receive();
+#endif
+    }
+  }
+  return true;
+}
+
+/*********************************************************************/
+
+Adafruit_BMP085_LinuxBus::Adafruit_BMP085_LinuxBus(const char *dev) {
+  device = dev;
+  fd = -1;
+}
+
+Adafruit_BMP085_LinuxBus::~Adafruit_BMP085_LinuxBus(void) {
+  end();
+}
+
+boolean Adafruit_BMP085_LinuxBus::begin(void) {
+#if defined(__linux__)
+  if (fd < 0) fd = open(device, O_RDWR);
+  return fd >= 0;
+#else
+  return false;
+#endif
+}
+
+void Adafruit_BMP085_LinuxBus::end(void) {
+#if defined(__linux__)
+  if (fd >= 0) close(fd);
+#endif
+  fd = -1;
+}
+
+boolean Adafruit_BMP085_LinuxBus::transfer(uint8_t addr, const uint8_t *wbuf,
+  uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+#if defined(__linux__)
+  struct i2c_msg msgs[2];
+  struct i2c_rdwr_ioctl_data xfer;
+  uint8_t n = 0;
+
+  if (fd < 0) return false;
+  if (wlen) {
+    msgs[n].addr  = addr;
+    msgs[n].flags = 0;
+    msgs[n].len   = wlen;
+    msgs[n].buf   = (uint8_t *)wbuf;
+    n++;
+  }
+  if (rlen) {
+    msgs[n].addr  = addr;
+    msgs[n].flags = I2C_M_RD;
+    msgs[n].len   = rlen;
+    msgs[n].buf   = rbuf;
+    n++;
+  }
+  if (!n) return true;
+  xfer.msgs  = msgs;
+  xfer.nmsgs = n;
+  return ioctl(fd, I2C_RDWR, &xfer) == n;
+#else
+  (void)addr; (void)wbuf; (void)wlen; (void)rbuf; (void)rlen;
+  return false;
+#endif
+}
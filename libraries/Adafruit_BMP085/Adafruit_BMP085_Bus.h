@@ -0,0 +1,74 @@
+#ifndef ADAFRUIT_BMP085_BUS_H
+#define ADAFRUIT_BMP085_BUS_H
+
+#if (ARDUINO >= 100)
+ #include "Arduino.h"
+#else
+ #include "WProgram.h"
+#endif
+
+// I2C access for Adafruit_BMP085.  All the driver needs is one primitive:
+// write some bytes to a device and, in the same transaction, read some
+// back after a repeated start.  A register read is then one transaction
+// however many registers it spans (the calibration block is 22), instead
+// of a write, a stop and a read per register.
+//
+//   Adafruit_BMP085_LinuxBus bus("/dev/i2c-1");
+//   bmp.setBus(&bus);
+//   bmp.begin();
+//
+// The default is Adafruit_BMP085_WireBus, over the Wire library.
+// Adafruit_BMP085_Sim (Adafruit_BMP085_Sim.h) is a simulated sensor for
+// running without one, and Adafruit_BMP085_Replay (Adafruit_BMP085_Trace.h)
+// plays back a recorded one.
+//
+// The bus is also the driver's clock, for conversion times and the age of
+// a temperature.  A replay keeps time of its own, so that it runs as fast
+// as it can rather than as long as the recording took.
+
+class Adafruit_BMP085_Bus {
+ public:
+  virtual ~Adafruit_BMP085_Bus(void) {}
+
+  virtual boolean begin(void) { return true; }
+
+  // Write wlen bytes to 'addr', then, if rlen, repeated start and read
+  // rlen bytes.  False if the device didn't acknowledge.
+  virtual boolean transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen) = 0;
+
+  virtual uint32_t micros(void) { return ::micros(); }
+  virtual uint32_t millis(void) { return ::millis(); }
+  virtual void     delay(uint32_t ms) { ::delay(ms); }
+  virtual void     delayMicroseconds(uint32_t us) { ::delayMicroseconds(us); }
+
+  boolean readRegs(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len);
+  boolean writeReg(uint8_t addr, uint8_t reg, uint8_t value);
+};
+
+// Arduino Wire; a read is at most the Wire buffer (32 bytes on AVR)
+class Adafruit_BMP085_WireBus : public Adafruit_BMP085_Bus {
+ public:
+  boolean begin(void);
+  boolean transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen);
+};
+
+// Linux i2c-dev: each transfer is a single I2C_RDWR ioctl.  Needs read and
+// write access to the device node (group i2c on Raspbian).
+class Adafruit_BMP085_LinuxBus : public Adafruit_BMP085_Bus {
+ public:
+  Adafruit_BMP085_LinuxBus(const char *device = "/dev/i2c-1");
+  ~Adafruit_BMP085_LinuxBus(void);
+
+  boolean begin(void);
+  void    end(void);
+  boolean transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen);
+
+ private:
+  const char *device;
+  int         fd;
+};
+
+#endif // ADAFRUIT_BMP085_BUS_H
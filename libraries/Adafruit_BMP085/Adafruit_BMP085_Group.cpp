@@ -0,0 +1,58 @@
+/***************************************************
+  Overlapped conversions on several BMP085s.  See Adafruit_BMP085_Group.h.
+ ****************************************************/
+
+#include "Adafruit_BMP085_Group.h"
+
+Adafruit_BMP085_Group::Adafruit_BMP085_Group(void) {
+  count = 0;
+  next = 0;
+}
+
+boolean Adafruit_BMP085_Group::add(Adafruit_BMP085 &sensor) {
+  if (count >= BMP085_GROUP_MAX) return false;
+  sensors[count++] = &sensor;
+  return true;
+}
+
+uint8_t Adafruit_BMP085_Group::size(void) {
+  return count;
+}
+
+// A sensor with a conversion already running keeps it; false then
+boolean Adafruit_BMP085_Group::start(void) {
+  boolean ok = true;
+  for (uint8_t i=0; i<count; i++)
+    if ((sensors[i]->getState() != BMP085_DONE) &&
+        !sensors[i]->startConversion())
+      ok = false;
+  return ok;
+}
+
+// Each sensor's poll() only touches the bus when its conversion is due
+boolean Adafruit_BMP085_Group::poll(void) {
+  uint8_t done = 0;
+  for (uint8_t k=0; k<count; k++) {
+    uint8_t i = next + k;
+    if (i >= count) i -= count;
+    if (sensors[i]->poll()) done++;
+  }
+  if (count && (++next >= count)) next = 0;
+  return done == count;
+}
+
+boolean Adafruit_BMP085_Group::collect(uint8_t i, float *temperature,
+  int32_t *pressure) {
+  if (i >= count) return false;
+  return sensors[i]->collect(temperature, pressure);
+}
+
+// Waits on the sensors' bus, so a replayed bus sees the time pass too
+void Adafruit_BMP085_Group::read(float *temperatures, int32_t *pressures) {
+  start();
+  while (!poll())
+    sensors[0]->getBus()->delayMicroseconds(100); // poll() with none is done
+  for (uint8_t i=0; i<count; i++)
+    collect(i, temperatures ? &temperatures[i] : NULL,
+      pressures ? &pressures[i] : NULL);
+}
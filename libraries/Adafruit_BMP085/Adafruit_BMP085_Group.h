@@ -0,0 +1,41 @@
+#ifndef ADAFRUIT_BMP085_GROUP_H
+#define ADAFRUIT_BMP085_GROUP_H
+
+#include "Adafruit_BMP085.h"
+
+#define BMP085_GROUP_MAX 8
+
+// Reads several BMP085s (e.g. behind an Adafruit_BMP085_Mux) at once:
+// start() starts a conversion on each, then poll() goes round them,
+// reading each sensor's results as they are due and moving it on.  The
+// conversions overlap, so a round costs about one sensor's conversion
+// time plus the bus traffic, instead of one conversion time per sensor.
+//
+//   Adafruit_BMP085_Group group;
+//   group.add(bmpA);
+//   group.add(bmpB);
+//   group.read(temperatures, pressures);  // Or start(), poll(), collect()
+//
+// Sensors must be begun, and not in continuous mode.  poll() starts with
+// a different sensor each call, so none waits behind the others' traffic
+// every time.
+
+class Adafruit_BMP085_Group {
+ public:
+  Adafruit_BMP085_Group(void);
+
+  boolean add(Adafruit_BMP085 &sensor);
+  uint8_t size(void);
+
+  boolean start(void);
+  boolean poll(void);       // True once every sensor's results are in
+  boolean collect(uint8_t i, float *temperature, int32_t *pressure);
+  // start(), poll() until done, collect() each; either array may be NULL
+  void    read(float *temperatures, int32_t *pressures);
+
+ private:
+  Adafruit_BMP085 *sensors[BMP085_GROUP_MAX];
+  uint8_t          count, next;
+};
+
+#endif // ADAFRUIT_BMP085_GROUP_H
@@ -0,0 +1,72 @@
+/***************************************************
+  TCA9548A multiplexer in front of several BMP085s.  See
+  Adafruit_BMP085_Mux.h.
+ ****************************************************/
+
+#include "Adafruit_BMP085_Mux.h"
+
+#define UNKNOWN 0xFE
+
+Adafruit_BMP085_Mux::Adafruit_BMP085_Mux(Adafruit_BMP085_Bus &b,
+  uint8_t addr) : bus(b) {
+  address = addr;
+  current = UNKNOWN;
+  started = false;
+  selects = 0;
+  for (uint8_t i=0; i<8; i++) {
+    channels[i].mux = this;
+    channels[i].number = i;
+  }
+}
+
+Adafruit_BMP085_Bus *Adafruit_BMP085_Mux::channel(uint8_t n) {
+  return &channels[n & 7];
+}
+
+// The control register has a bit per channel; one at a time here
+boolean Adafruit_BMP085_Mux::select(uint8_t n) {
+  if (n == current) return true;
+  uint8_t mask = (n < 8) ? (1 << n) : 0;
+  selects++;
+  if (!bus.transfer(address, &mask, 1, NULL, 0)) {
+    current = UNKNOWN;
+    return false;
+  }
+  current = n;
+  return true;
+}
+
+uint32_t Adafruit_BMP085_Mux::getSelects(void) {
+  return selects;
+}
+
+// Each sensor's begin() gets here; the bus underneath is begun once
+boolean Adafruit_BMP085_MuxChannel::begin(void) {
+  if (!mux->started) {
+    if (!mux->bus.begin()) return false;
+    mux->started = true;
+  }
+  return mux->select(number);
+}
+
+boolean Adafruit_BMP085_MuxChannel::transfer(uint8_t addr,
+  const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  return mux->select(number) &&
+    mux->bus.transfer(addr, wbuf, wlen, rbuf, rlen);
+}
+
+uint32_t Adafruit_BMP085_MuxChannel::micros(void) {
+  return mux->bus.micros();
+}
+
+uint32_t Adafruit_BMP085_MuxChannel::millis(void) {
+  return mux->bus.millis();
+}
+
+void Adafruit_BMP085_MuxChannel::delay(uint32_t ms) {
+  mux->bus.delay(ms);
+}
+
+void Adafruit_BMP085_MuxChannel::delayMicroseconds(uint32_t us) {
+  mux->bus.delayMicroseconds(us);
+}
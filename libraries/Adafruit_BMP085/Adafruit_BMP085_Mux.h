@@ -0,0 +1,54 @@
+#ifndef ADAFRUIT_BMP085_MUX_H
+#define ADAFRUIT_BMP085_MUX_H
+
+#include "Adafruit_BMP085_Bus.h"
+
+// A TCA9548A (or PCA9548A) I2C multiplexer, so that several BMP085s,
+// which all answer at 0x77, can share a bus.  channel(n) is a bus that
+// switches the mux to downstream channel n before each transfer, when it
+// isn't already there:
+//
+//   Adafruit_BMP085_Mux mux(bus, 0x70);
+//   bmpA.setBus(mux.channel(0));
+//   bmpB.setBus(mux.channel(1));
+//
+// The mux's own address is 0x70-0x77 by its A0-A2 pins; 0x77 would clash
+// with the sensors.  Sensors behind a mux share an address, so give each
+// its own calibration cache directory.
+
+class Adafruit_BMP085_Mux;
+
+class Adafruit_BMP085_MuxChannel : public Adafruit_BMP085_Bus {
+ public:
+  boolean begin(void);
+  boolean transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen);
+  uint32_t micros(void);  // The clock of the bus underneath
+  uint32_t millis(void);
+  void     delay(uint32_t ms);
+  void     delayMicroseconds(uint32_t us);
+
+ private:
+  friend class Adafruit_BMP085_Mux;
+  Adafruit_BMP085_Mux *mux;
+  uint8_t              number;
+};
+
+class Adafruit_BMP085_Mux {
+ public:
+  Adafruit_BMP085_Mux(Adafruit_BMP085_Bus &bus, uint8_t addr = 0x70);
+
+  Adafruit_BMP085_Bus *channel(uint8_t n);    // 0-7
+  boolean  select(uint8_t n);                 // 0xFF: none
+  uint32_t getSelects(void);                  // Channel switches so far
+
+ private:
+  friend class Adafruit_BMP085_MuxChannel;
+  Adafruit_BMP085_Bus       &bus;
+  Adafruit_BMP085_MuxChannel channels[8];
+  uint8_t                    address, current; // current 0xFE: unknown
+  boolean                    started;
+  uint32_t                   selects;
+};
+
+#endif // ADAFRUIT_BMP085_MUX_H
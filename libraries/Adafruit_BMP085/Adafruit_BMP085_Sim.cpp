@@ -0,0 +1,187 @@
+/***************************************************
+  Simulated BMP085 for host runs.  See Adafruit_BMP085_Sim.h.
+ ****************************************************/
+
+#include <string.h>
+#include "Adafruit_BMP085_Sim.h"
+
+// Datasheet example: AC1..AC6, B1, B2, MB, MC, MD
+static const int16_t datasheetCal[11] = {
+  408, -72, -14383, (int16_t)32741, (int16_t)32757, 23153,
+  6190, 4, -32768, -8711, 2868
+};
+
+// BMP280 datasheet example: dig_T1..dig_T3, dig_P1..dig_P9
+static const int16_t datasheetCal280[12] = {
+  (int16_t)27504, 26435, -1000, (int16_t)36477, -10685, 3024,
+  2855, 140, -7, 15500, -14600, 6000
+};
+
+Adafruit_BMP085_Sim::Adafruit_BMP085_Sim(uint8_t addr, uint8_t id) {
+  uint8_t prom[24];
+
+  memset(regs, 0, sizeof(regs));
+  chip = id;
+  regs[0xD0] = chip;
+  if (chip == BMP280_CHIPID) {
+    for (uint8_t i=0; i<12; i++) {
+      prom[2*i]   = (uint16_t)datasheetCal280[i] & 0xFF;
+      prom[2*i+1] = (uint16_t)datasheetCal280[i] >> 8;
+    }
+    setRaw(519888, 415148);
+  } else {
+    for (uint8_t i=0; i<11; i++) {
+      prom[2*i]   = (uint16_t)datasheetCal[i] >> 8;
+      prom[2*i+1] = (uint16_t)datasheetCal[i] & 0xFF;
+    }
+    setRaw(27898, 23843UL << 3);
+  }
+  setCalibration(prom);
+  address = addr;
+  ptr = 0;
+  pending = 0;
+  resetCounters();
+}
+
+void Adafruit_BMP085_Sim::setCalibration(const uint8_t *prom) {
+  if (chip == BMP280_CHIPID)
+    memcpy(&regs[BMP280_CAL_T1], prom, 24);
+  else
+    memcpy(&regs[BMP085_CAL_AC1], prom, 22);
+}
+
+void Adafruit_BMP085_Sim::setRaw(uint32_t UT, uint32_t UP) {
+  ut = UT;
+  up = UP;
+}
+
+uint32_t Adafruit_BMP085_Sim::getTransactions(void) const {
+  return transactions;
+}
+
+uint32_t Adafruit_BMP085_Sim::getBytes(void) const {
+  return bytes;
+}
+
+void Adafruit_BMP085_Sim::resetCounters(void) {
+  transactions = 0;
+  bytes = 0;
+}
+
+// Latch a finished conversion into the result registers
+void Adafruit_BMP085_Sim::update(void) {
+  if (!pending || ((micros() - started) < duration)) return;
+  if (chip == BMP280_CHIPID) {
+    // Normal mode: pressure then temperature, 20 bits each, left-justified
+    uint32_t r = up << 4, t = ut << 4;
+    regs[0xF7] = r >> 16;
+    regs[0xF8] = r >> 8;
+    regs[0xF9] = r;
+    regs[0xFA] = t >> 16;
+    regs[0xFB] = t >> 8;
+    regs[0xFC] = t;
+    // The next ends a period later, or now if polled late
+    uint32_t elapsed = micros() - started;
+    started += (elapsed / duration) * duration;
+    return;
+  }
+  if (pending == BMP085_READTEMPCMD) {
+    regs[0xF6] = ut >> 8;
+    regs[0xF7] = ut;
+  } else {
+    uint32_t r = up << 5; // 19 bits, left-justified in 24
+    regs[0xF6] = r >> 16;
+    regs[0xF7] = r >> 8;
+    regs[0xF8] = r;
+  }
+  regs[BMP085_CONTROL] &= ~0x20; // Sco: conversion complete
+  pending = 0;
+}
+
+boolean Adafruit_BMP085_Sim::transfer(uint8_t addr, const uint8_t *wbuf,
+  uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  static const uint16_t pressureTimes[4] = { 4500, 7500, 13500, 25500 };
+
+  transactions++;
+  bytes += (wlen ? 1 + wlen : 0) + (rlen ? 1 + rlen : 0);
+  if (addr != address) return false;
+
+  update();
+  if (wlen) {
+    ptr = wbuf[0];
+    // Register writes; only the control register starts anything
+    for (uint8_t i=1; i<wlen; i++, ptr++) {
+      regs[ptr] = wbuf[i];
+      if ((ptr == BMP085_CONTROL) && (chip == BMP280_CHIPID)) {
+        // Normal mode (3) measures every period; anything else stops
+        uint8_t osrs = (wbuf[i] >> 2) & 7;
+        pending = ((wbuf[i] & 3) == 3) && osrs;
+        if (pending) {
+          if (osrs > 5) osrs = 5; // x16
+          duration = 4625 + (2300UL << (osrs - 1));
+          started = micros();
+        }
+      } else if (ptr == BMP085_CONTROL) {
+        uint8_t cmd = wbuf[i];
+        if (cmd == BMP085_READTEMPCMD) {
+          pending = cmd;
+          duration = 4500;
+        } else if ((cmd & 0x3F) == BMP085_READPRESSURECMD) {
+          pending = cmd;
+          duration = pressureTimes[cmd >> 6];
+        }
+        if (pending) {
+          started = micros();
+          regs[BMP085_CONTROL] |= 0x20;
+        }
+      }
+    }
+  }
+  for (uint8_t i=0; i<rlen; i++)
+    rbuf[i] = regs[ptr++];
+  return true;
+}
+
+/*********************************************************************/
+
+Adafruit_BMP085_SimMux::Adafruit_BMP085_SimMux(uint8_t addr) {
+  address = addr;
+  control = 0; // All channels off at power-up
+  transactions = 0;
+  for (uint8_t i=0; i<8; i++) devices[i] = NULL;
+}
+
+void Adafruit_BMP085_SimMux::attach(uint8_t channel, Adafruit_BMP085_Bus *d) {
+  devices[channel & 7] = d;
+}
+
+uint8_t Adafruit_BMP085_SimMux::getControl(void) const {
+  return control;
+}
+
+uint32_t Adafruit_BMP085_SimMux::getTransactions(void) const {
+  return transactions;
+}
+
+boolean Adafruit_BMP085_SimMux::transfer(uint8_t addr, const uint8_t *wbuf,
+  uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  transactions++;
+  if (addr == address) {
+    if (wlen) control = wbuf[wlen - 1];
+    for (uint8_t i=0; i<rlen; i++) rbuf[i] = control;
+    return true;
+  }
+
+  uint8_t tmp[32];
+  boolean ack = false;
+  if (rlen > sizeof(tmp)) return false;
+  for (uint8_t i=0; i<rlen; i++) rbuf[i] = 0xFF; // Pulled up
+  for (uint8_t ch=0; ch<8; ch++) {
+    if (!(control & (1 << ch)) || !devices[ch]) continue;
+    if (devices[ch]->transfer(addr, wbuf, wlen, tmp, rlen)) {
+      ack = true;
+      for (uint8_t i=0; i<rlen; i++) rbuf[i] &= tmp[i];
+    }
+  }
+  return ack;
+}
@@ -0,0 +1,85 @@
+#ifndef ADAFRUIT_BMP085_SIM_H
+#define ADAFRUIT_BMP085_SIM_H
+
+#include "Adafruit_BMP085.h"
+
+// A BMP085 on a bus of its own, in software: chip id, calibration PROM,
+// the control register and conversions that take the datasheet's maximum
+// time by micros(), with the raw results set by the caller.  Until a
+// conversion finishes its result registers hold the previous one, as on
+// the chip.  Plug it in with setBus() to run the driver on a host:
+//
+//   Adafruit_BMP085_Sim sim;
+//   sim.setRaw(27898, 23843 << 3); // The datasheet's example
+//   bmp.setBus(&sim);
+//   bmp.begin(BMP085_ULTRALOWPOWER); // readTemperature() 15.0, readPressure() 69964
+//
+// Transactions and bytes are counted, to see what the driver costs.
+//
+// Given BMP280_CHIPID it is a BMP280 instead: 24 PROM bytes from 0x88
+// (little-endian words), and in normal mode a new measurement every
+// period for its oversampling, the latest in the result registers.
+
+class Adafruit_BMP085_Sim : public Adafruit_BMP085_Bus {
+ public:
+  Adafruit_BMP085_Sim(uint8_t addr = BMP085_I2CADDR,
+    uint8_t chip = BMP085_CHIPID);
+
+  // The PROM bytes, as the chip returns them; that datasheet's example
+  // coefficients until set
+  void setCalibration(const uint8_t *prom);
+  // Results of the next conversions: UT, and UP at ultra high resolution
+  // (19 bits; lower modes get its top bits).  BMP280: both 20 bits.
+  void setRaw(uint32_t UT, uint32_t UP);
+
+  uint32_t getTransactions(void) const;
+  uint32_t getBytes(void) const;    // Address bytes included
+  void     resetCounters(void);
+
+  boolean transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen);
+
+ private:
+  void update(void);
+
+  uint8_t  regs[256];
+  uint8_t  address, ptr;
+  uint8_t  chip;
+  uint8_t  pending;            // Control byte of the conversion running, or 0
+  uint32_t started, duration;  // micros()
+  uint32_t ut;
+  uint32_t up;
+  uint32_t transactions, bytes;
+};
+
+// A simulated TCA9548A: a bus with the mux at 'addr' and simulated
+// devices (or any bus) on its eight channels.  Transfers to other
+// addresses go to every channel enabled in the control register, and are
+// acknowledged if a device there acknowledges; bytes read from several at
+// once are ANDed, as on the open-drain bus.  For running the multi-sensor
+// code on a host:
+//
+//   Adafruit_BMP085_Sim    a, b;
+//   Adafruit_BMP085_SimMux bus;
+//   bus.attach(0, &a);
+//   bus.attach(1, &b);
+//   Adafruit_BMP085_Mux mux(bus);
+
+class Adafruit_BMP085_SimMux : public Adafruit_BMP085_Bus {
+ public:
+  Adafruit_BMP085_SimMux(uint8_t addr = 0x70);
+
+  void     attach(uint8_t channel, Adafruit_BMP085_Bus *device);
+  uint8_t  getControl(void) const;
+  uint32_t getTransactions(void) const; // Including the mux's own
+
+  boolean transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen);
+
+ private:
+  Adafruit_BMP085_Bus *devices[8];
+  uint8_t  address, control;
+  uint32_t transactions;
+};
+
+#endif // ADAFRUIT_BMP085_SIM_H
@@ -0,0 +1,218 @@
+/***************************************************
+  Bus traffic traces of the BMP085 driver, recorded and replayed.  See
+  Adafruit_BMP085_Trace.h.
+ ****************************************************/
+
+#include <string.h>
+#include "Adafruit_BMP085_Trace.h"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+ #define BMP085_TRACE_FILES
+#endif
+
+#define TRACE_VERSION 1
+#define NACK          0x80
+
+Adafruit_BMP085_Recorder::Adafruit_BMP085_Recorder(Adafruit_BMP085_Bus &b)
+  : bus(b) {
+  fp = NULL;
+  last = bytes = 0;
+}
+
+Adafruit_BMP085_Recorder::~Adafruit_BMP085_Recorder(void) {
+  close();
+}
+
+boolean Adafruit_BMP085_Recorder::open(const char *path) {
+  close();
+#ifdef BMP085_TRACE_FILES
+  static const uint8_t header[8] = { 'B', 'M', 'P', 'T', TRACE_VERSION };
+
+  fp = fopen(path, "wb");
+  if (!fp) return false;
+  if (fwrite(header, 1, sizeof(header), fp) != sizeof(header)) {
+    close();
+    return false;
+  }
+  last = 0; // The first record holds the time since startup
+  bytes = sizeof(header);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Adafruit_BMP085_Recorder::close(void) {
+  if (fp) fclose(fp);
+  fp = NULL;
+}
+
+uint32_t Adafruit_BMP085_Recorder::getBytes(void) const {
+  return bytes;
+}
+
+boolean Adafruit_BMP085_Recorder::begin(void) {
+  return bus.begin();
+}
+
+// Flushed record by record, so that a killed process leaves a trace that
+// replays up to its last transfer
+boolean Adafruit_BMP085_Recorder::transfer(uint8_t addr, const uint8_t *wbuf,
+  uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  uint32_t now = bus.micros();
+  boolean ack = bus.transfer(addr, wbuf, wlen, rbuf, rlen);
+  if (!fp) return ack;
+
+  uint8_t head[8], n = 0;
+  uint32_t delta = now - last;
+  last = now;
+  do {
+    head[n++] = (delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0);
+    delta >>= 7;
+  } while (delta);
+  head[n++] = (addr & 0x7F) | (ack ? 0 : NACK);
+  head[n++] = wlen;
+  head[n++] = rlen;
+  if (!ack) rlen = 0;
+  if ((fwrite(head, 1, n, fp) != n) ||
+      (wlen && (fwrite(wbuf, 1, wlen, fp) != wlen)) ||
+      (rlen && (fwrite(rbuf, 1, rlen, fp) != rlen)) ||
+      (fflush(fp) != 0)) {
+    close(); // Disk full: stop rather than leave a torn record
+    return ack;
+  }
+  bytes += n + wlen + rlen;
+  return ack;
+}
+
+uint32_t Adafruit_BMP085_Recorder::micros(void) {
+  return bus.micros();
+}
+
+uint32_t Adafruit_BMP085_Recorder::millis(void) {
+  return bus.millis();
+}
+
+void Adafruit_BMP085_Recorder::delay(uint32_t ms) {
+  bus.delay(ms);
+}
+
+void Adafruit_BMP085_Recorder::delayMicroseconds(uint32_t us) {
+  bus.delayMicroseconds(us);
+}
+
+/*********************************************************************/
+
+Adafruit_BMP085_Replay::Adafruit_BMP085_Replay(void) {
+  fp = NULL;
+  clock = at = 0;
+  pending = false;
+  transfers = mismatches = 0;
+}
+
+Adafruit_BMP085_Replay::~Adafruit_BMP085_Replay(void) {
+  close();
+}
+
+boolean Adafruit_BMP085_Replay::open(const char *path) {
+  close();
+  clock = at = 0;
+  transfers = mismatches = 0;
+#ifdef BMP085_TRACE_FILES
+  uint8_t header[8];
+
+  fp = fopen(path, "rb");
+  if (!fp) return false;
+  if ((fread(header, 1, sizeof(header), fp) != sizeof(header)) ||
+      memcmp(header, "BMPT", 4) || (header[4] != TRACE_VERSION)) {
+    close();
+    return false;
+  }
+  fetch();
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Adafruit_BMP085_Replay::close(void) {
+  if (fp) fclose(fp);
+  fp = NULL;
+  pending = false;
+}
+
+// Read the next record ahead; a torn one at the end is the end
+boolean Adafruit_BMP085_Replay::fetch(void) {
+  uint32_t delta = 0;
+  uint8_t shift = 0, head[3];
+  int c;
+
+  pending = false;
+  if (!fp) return false;
+  do {
+    if (((c = fgetc(fp)) == EOF) || (shift > 28)) return false;
+    delta |= (uint32_t)(c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  if (fread(head, 1, 3, fp) != 3) return false;
+  addr = head[0] & 0x7F;
+  ack = !(head[0] & NACK);
+  wlen = head[1];
+  rlen = head[2];
+  if (fread(wbuf, 1, wlen, fp) != wlen) return false;
+  if (ack && (fread(rbuf, 1, rlen, fp) != rlen)) return false;
+  at += delta;
+  pending = true;
+  return true;
+}
+
+boolean Adafruit_BMP085_Replay::done(void) const {
+  return !pending;
+}
+
+void Adafruit_BMP085_Replay::idle(void) {
+  if (pending && (at > clock))
+    clock = at;
+  else
+    clock += 1000;
+}
+
+uint32_t Adafruit_BMP085_Replay::getTransfers(void) const {
+  return transfers;
+}
+
+uint32_t Adafruit_BMP085_Replay::getMismatches(void) const {
+  return mismatches;
+}
+
+// Past the end of the trace nothing answers
+boolean Adafruit_BMP085_Replay::transfer(uint8_t a, const uint8_t *w,
+  uint8_t wl, uint8_t *r, uint8_t rl) {
+  if (!pending) return false;
+  transfers++;
+  if (at > clock) clock = at;
+  if ((a != addr) || (wl != wlen) || (rl != rlen) ||
+      (wl && memcmp(w, wbuf, wl)))
+    mismatches++;
+  for (uint8_t i=0; i<rl; i++)
+    r[i] = (ack && (i < rlen)) ? rbuf[i] : 0xFF;
+  boolean ret = ack;
+  fetch();
+  return ret;
+}
+
+uint32_t Adafruit_BMP085_Replay::micros(void) {
+  return clock;
+}
+
+uint32_t Adafruit_BMP085_Replay::millis(void) {
+  return clock / 1000;
+}
+
+void Adafruit_BMP085_Replay::delay(uint32_t ms) {
+  clock += (uint64_t)ms * 1000;
+}
+
+void Adafruit_BMP085_Replay::delayMicroseconds(uint32_t us) {
+  clock += us;
+}
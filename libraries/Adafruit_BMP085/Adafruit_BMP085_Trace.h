@@ -0,0 +1,116 @@
+#ifndef ADAFRUIT_BMP085_TRACE_H
+#define ADAFRUIT_BMP085_TRACE_H
+
+#include "Adafruit_BMP085_Bus.h"
+#include <stdio.h>
+
+// Recording a sensor's bus traffic, and playing it back to the driver
+// without the sensor, e.g. for regression tests and benchmarks on a
+// build machine.
+//
+// Adafruit_BMP085_Recorder goes between the driver and the real bus and
+// logs every transfer with its micros() time: the calibration PROM, the
+// commands and every UT and UP as the chip returned them.
+//
+//   Adafruit_BMP085_WireBus  wire;
+//   Adafruit_BMP085_Recorder recorder(wire);
+//   recorder.open("bmp085.trace");
+//   bmp.setBus(&recorder);
+//
+// Adafruit_BMP085_Replay answers the driver's transfers from the trace in
+// order, and keeps a clock of its own.  Each transfer sets it to the time
+// the transfer was recorded, and the driver's delays only add to it.  A
+// replay therefore takes no longer than the driver's own work, and its
+// results match those taken live.
+//
+//   Adafruit_BMP085_Replay replay;
+//   replay.open("bmp085.trace");
+//   bmp.setBus(&replay);
+//   bmp.begin();
+//   while (!replay.done()) {
+//     if (replay.millis() - timer > 60000UL) { ...readAll()... }
+//     replay.idle();
+//   }
+//
+// The driver's blocking reads, and Adafruit_BMP085_Group::read(), wait
+// through the bus and so move the clock on themselves.  A program that
+// polls instead (startConversion() and poll(), Group::start() and poll(),
+// continuous mode) only sees time pass if it waits through the bus too:
+// call idle(), delay() or delayMicroseconds() on the replay between polls,
+// where it would otherwise sleep or do other work, or it polls forever.
+//
+// A transfer that isn't the one recorded (another register, mode or
+// length) still gets the recorded answer, and is counted in
+// getMismatches(); the driver, not the trace, has changed.
+//
+// The trace is "BMPT", a version byte and three zero bytes, then a
+// record per transfer: the microseconds since the previous one (a
+// little-endian base-128 varint), the address with bit 7 set if it
+// wasn't acknowledged, the lengths written and read, the bytes written
+// and, if acknowledged, the bytes read.  A BMP085 read each minute adds
+// about 50 kB a day.  Times are micros() differences, so a gap of over
+// 71 minutes between two transfers loses whole wraps of micros().
+// Files need a hosted C library (Linux, macOS, Windows); elsewhere open()
+// returns false and the recorder only passes transfers on.
+
+class Adafruit_BMP085_Recorder : public Adafruit_BMP085_Bus {
+ public:
+  Adafruit_BMP085_Recorder(Adafruit_BMP085_Bus &bus);
+  ~Adafruit_BMP085_Recorder(void);
+
+  boolean  open(const char *path);  // Truncates; false if it can't
+  void     close(void);
+  uint32_t getBytes(void) const;    // Written to the trace so far
+
+  boolean  begin(void);
+  boolean  transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen);
+  uint32_t micros(void);            // The clock of the bus recorded
+  uint32_t millis(void);
+  void     delay(uint32_t ms);
+  void     delayMicroseconds(uint32_t us);
+
+ private:
+  Adafruit_BMP085_Bus &bus;
+  FILE     *fp;
+  uint32_t  last, bytes;             // micros() of the last record
+};
+
+class Adafruit_BMP085_Replay : public Adafruit_BMP085_Bus {
+ public:
+  Adafruit_BMP085_Replay(void);
+  ~Adafruit_BMP085_Replay(void);
+
+  boolean  open(const char *path);  // False if it isn't a trace
+  void     close(void);
+  boolean  done(void) const;        // Every transfer served
+
+  // Move the clock on while the program has nothing to do: to the time
+  // of the next transfer recorded, or by a millisecond if that has passed
+  void     idle(void);
+
+  uint32_t getTransfers(void) const;
+  uint32_t getMismatches(void) const;
+
+  boolean  transfer(uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+    uint8_t *rbuf, uint8_t rlen);
+  uint32_t micros(void);
+  uint32_t millis(void);
+  void     delay(uint32_t ms);
+  void     delayMicroseconds(uint32_t us);
+
+ private:
+  boolean  fetch(void);
+
+  FILE     *fp;
+  uint64_t  clock;                   // Microseconds as recorded, unwrapped
+  // The next record, read ahead for idle()
+  boolean   pending;
+  uint64_t  at;
+  uint8_t   addr, wlen, rlen;
+  boolean   ack;
+  uint8_t   wbuf[255], rbuf[255];
+  uint32_t  transfers, mismatches;
+};
+
+#endif // ADAFRUIT_BMP085_TRACE_H
@@ -0,0 +1,64 @@
+#include <Wire.h>
+#include <Adafruit_BMP085.h>
+
+// Micro-benchmark of the integer altitude and sea-level functions against
+// the float formulas readAltitude() and readSealevelPressure() use.  No
+// sensor needed: it sweeps pressures over the chip's range, times both
+// paths and prints the time per sample and the largest differences.
+
+#define SAMPLES  20000
+#define ALTITUDE 688 // m, as in the gateway example
+
+volatile int32_t sink; // Keeps the compiler from dropping the loops
+// Read afresh each sample, as a sensor's would be, so that neither loop
+// gets its altitude term hoisted out
+volatile int32_t altitude = ALTITUDE * 100L; // cm
+
+int32_t pressureAt(uint16_t i) {
+  return 30000 + (int32_t)i * (80000L / SAMPLES);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  unsigned long t = micros();
+  for (uint16_t i=0; i<SAMPLES; i++) {
+    float pressure = pressureAt(i);
+    float meters = altitude / 100.0;
+    sink = (int32_t)(pressure / pow(1.0-meters/44330.0, 5.255));
+    sink = 100 * 44330 * (1.0 - pow(pressure / 101325, 0.1903));
+  }
+  unsigned long tFloat = micros() - t;
+
+  t = micros();
+  for (uint16_t i=0; i<SAMPLES; i++) {
+    int32_t pressure = pressureAt(i);
+    sink = Adafruit_BMP085::sealevelPressureFixed(pressure, altitude);
+    sink = Adafruit_BMP085::altitudeFixed(pressure);
+  }
+  unsigned long tFixed = micros() - t;
+
+  int32_t worstSea = 0;
+  float worstAlt = 0;
+  for (uint16_t i=0; i<SAMPLES; i++) {
+    int32_t p = pressureAt(i);
+    float pressure = p;
+    int32_t sea = (int32_t)(pressure / pow(1.0-ALTITUDE/44330.0, 5.255));
+    float alt = 100 * 44330 * (1.0 - pow(pressure / 101325, 0.1903));
+    int32_t dSea = abs(Adafruit_BMP085::sealevelPressureFixed(p, ALTITUDE * 100L) - sea);
+    float dAlt = fabs(Adafruit_BMP085::altitudeFixed(p) - alt);
+    if (dSea > worstSea) worstSea = dSea;
+    if (dAlt > worstAlt) worstAlt = dAlt;
+  }
+
+  Serial.print("float: "); Serial.print(1000.0 * tFloat / SAMPLES);
+  Serial.println(" ns per sample");
+  Serial.print("fixed: "); Serial.print(1000.0 * tFixed / SAMPLES);
+  Serial.println(" ns per sample");
+  Serial.print("largest difference: sea-level "); Serial.print(worstSea);
+  Serial.print(" Pa, altitude "); Serial.print(worstAlt);
+  Serial.println(" cm");
+}
+
+void loop() {
+}
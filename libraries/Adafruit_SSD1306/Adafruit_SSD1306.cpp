@@ -20,20 +20,51 @@ All text above, and the splash screen below must be included in any redistributi
   #include <avr/pgmspace.h>
 #elif defined(ESP8266) || defined(ESP32)
  #include <pgmspace.h>
-#else
+#endif
+// Only where the platform headers don't have them (they match
+// Adafruit_GFX.cpp's)
+#ifndef pgm_read_byte
  #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
 #endif
+#ifndef pgm_read_word
+ #define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#endif
+#ifndef pgm_read_dword
+ #define pgm_read_dword(addr) (*(const unsigned long *)(addr))
+#endif
+#ifndef pgm_read_pointer
+ #if !defined(__INT_MAX__) || (__INT_MAX__ > 0xFFFF)
+  #define pgm_read_pointer(addr) ((void *)pgm_read_dword(addr))
+ #else
+  #define pgm_read_pointer(addr) ((void *)pgm_read_word(addr))
+ #endif
+#endif
 
-#if !defined(__ARM_ARCH) && !defined(ENERGIA) && !defined(ESP8266) && !defined(ESP32) && !defined(__arc__)
+#if !defined(__ARM_ARCH) && !defined(ENERGIA) && !defined(ESP8266) && !defined(ESP32) && !defined(__arc__) && !defined(__linux__)
  #include <util/delay.h>
 #endif
 
 #include <stdlib.h>
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define SSD1306_NEON
+#elif defined(__SSE2__)
+ #include <emmintrin.h>
+ #define SSD1306_SSE2
+#endif
+#if defined(__SSE4_2__)
+ #include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+ #include <arm_acle.h>
+#endif
+
 #include <Wire.h>
 #include <SPI.h>
 #include "Adafruit_GFX.h"
 #include "Adafruit_SSD1306.h"
+#include "Adafruit_SSD1306_Capture.h"
+#include "Adafruit_SSD1306_Mirror.h"
 
 // the memory buffer for the LCD
 
@@ -116,7 +147,7 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
     return;
 
   // check rotation, move pixel around if necessary
-  switch (getRotation()) {
+  switch (frameRotation) {
   case 1:
     ssd1306_swap(x, y);
     x = WIDTH - x - 1;
@@ -134,9 +165,9 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
   // x is which column
     switch (color)
     {
-      case WHITE:   buffer[x+ (y/8)*SSD1306_LCDWIDTH] |=  (1 << (y&7)); break;
-      case BLACK:   buffer[x+ (y/8)*SSD1306_LCDWIDTH] &= ~(1 << (y&7)); break;
-      case INVERSE: buffer[x+ (y/8)*SSD1306_LCDWIDTH] ^=  (1 << (y&7)); break;
+      case WHITE:   frame[x+ (y/8)*frameWidth] |=  (1 << (y&7)); break;
+      case BLACK:   frame[x+ (y/8)*frameWidth] &= ~(1 << (y&7)); break;
+      case INVERSE: frame[x+ (y/8)*frameWidth] ^=  (1 << (y&7)); break;
     }
 
 }
@@ -148,6 +179,12 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RS
   sclk = SCLK;
   sid = SID;
   hwSPI = false;
+  scratch = NULL;
+  selectFrame();
+  capture = NULL;
+  mirror = NULL;
+  sentValid = false;
+  resetDisplayStats();
 }
 
 // constructor for hardware SPI - we indicate DataCommand, ChipSelect, Reset
@@ -156,6 +193,12 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS) : Adafruit_
   rst = RST;
   cs = CS;
   hwSPI = true;
+  scratch = NULL;
+  selectFrame();
+  capture = NULL;
+  mirror = NULL;
+  sentValid = false;
+  resetDisplayStats();
 }
 
 // initializer for I2C - we only indicate the reset pin!
@@ -163,6 +206,16 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t reset) :
 Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
   sclk = dc = cs = sid = -1;
   rst = reset;
+  scratch = NULL;
+  selectFrame();
+  capture = NULL;
+  mirror = NULL;
+  sentValid = false;
+  resetDisplayStats();
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306(void) {
+  if(scratch) free(scratch);
 }
 
 
@@ -171,7 +224,10 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr, bool reset) {
   _i2caddr = i2caddr;
 
   // set pin directions
-  if (sid != -1){
+  if (capture) {
+    // Headless: no pins or bus
+  }
+  else if (sid != -1){
     pinMode(dc, OUTPUT);
     pinMode(cs, OUTPUT);
 #ifdef HAVE_PORTREG
@@ -210,7 +266,7 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr, bool reset) {
     TWI1->TWI_CWGR = ((VARIANT_MCK / (2 * 400000)) - 4) * 0x101;
 #endif
   }
-  if ((reset) && (rst >= 0)) {
+  if ((reset) && (rst >= 0) && !capture) {
     // Setup reset pin direction (used by both SPI and I2C)
     pinMode(rst, OUTPUT);
     digitalWrite(rst, HIGH);
@@ -285,6 +341,8 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr, bool reset) {
   ssd1306_command(SSD1306_DEACTIVATE_SCROLL);
 
   ssd1306_command(SSD1306_DISPLAYON);//--turn on oled panel
+
+  sentValid = false; // GDDRAM holds whatever it powered up with
 }
 
 
@@ -297,7 +355,11 @@ void Adafruit_SSD1306::invertDisplay(uint8_t i) {
 }
 
 void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
-  if (sid != -1)
+  if (capture)
+  {
+    capture->command(c);
+  }
+  else if (sid != -1)
   {
     // SPI
 #ifdef HAVE_PORTREG
@@ -340,6 +402,7 @@ void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop){
   ssd1306_command(0X00);
   ssd1306_command(0XFF);
   ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  sentValid = false; // Scrolling rewrites GDDRAM
 }
 
 // startscrollleft
@@ -355,6 +418,7 @@ void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop){
   ssd1306_command(0X00);
   ssd1306_command(0XFF);
   ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  sentValid = false; // Scrolling rewrites GDDRAM
 }
 
 // startscrolldiagright
@@ -372,6 +436,7 @@ void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
   ssd1306_command(stop);
   ssd1306_command(0X01);
   ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  sentValid = false; // Scrolling rewrites GDDRAM
 }
 
 // startscrolldiagleft
@@ -389,10 +454,13 @@ void Adafruit_SSD1306::startscrolldiagleft(uint8_t start, uint8_t stop){
   ssd1306_command(stop);
   ssd1306_command(0X01);
   ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  sentValid = false; // Scrolling rewrites GDDRAM
 }
 
+// GDDRAM is left as scrolled and must be rewritten whole (datasheet, 0x2E)
 void Adafruit_SSD1306::stopscroll(void){
   ssd1306_command(SSD1306_DEACTIVATE_SCROLL);
+  sentValid = false;
 }
 
 // Dim the display
@@ -416,24 +484,220 @@ void Adafruit_SSD1306::dim(boolean dim) {
   ssd1306_command(contrast);
 }
 
-void Adafruit_SSD1306::display(void) {
-  ssd1306_command(SSD1306_COLUMNADDR);
-  ssd1306_command(0);   // Column start address (0 = reset)
-  ssd1306_command(SSD1306_LCDWIDTH-1); // Column end address (127 = reset)
+// Switching the drawing target carries what was drawn over, so that the
+// frame looks the same as without deferral: leaving the scratch frame
+// rotates it into the frame buffer, entering it un-rotates the frame
+// buffer into it.
+boolean Adafruit_SSD1306::setDeferredRotation(boolean enable) {
+  if(enable && !scratch) {
+    scratch = (uint8_t *)malloc(SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8);
+    if(!scratch) return false;
+    selectFrame();
+    if(frame != buffer) unrotateFrame();
+  } else if(!enable && scratch) {
+    if(frame != buffer) rotateFrame();
+    free(scratch);
+    scratch = NULL;
+    selectFrame();
+  }
+  return true;
+}
 
-  ssd1306_command(SSD1306_PAGEADDR);
-  ssd1306_command(0); // Page start address (0 = reset)
-  #if SSD1306_LCDHEIGHT == 64
-    ssd1306_command(7); // Page end address
-  #endif
-  #if SSD1306_LCDHEIGHT == 32
-    ssd1306_command(3); // Page end address
-  #endif
-  #if SSD1306_LCDHEIGHT == 16
-    ssd1306_command(1); // Page end address
-  #endif
-
-  if (sid != -1)
+void Adafruit_SSD1306::setRotation(uint8_t r) {
+  if((r & 3) == rotation) return;
+  if(frame != buffer) rotateFrame(); // With the rotation it was drawn in
+  Adafruit_GFX::setRotation(r);
+  selectFrame();
+  if(frame != buffer) unrotateFrame();
+}
+
+void Adafruit_SSD1306::selectFrame(void) {
+  if(scratch && (rotation & 1)) {
+    frame         = scratch;
+    frameWidth    = HEIGHT;
+    frameHeight   = WIDTH;
+    frameRotation = 0;
+  } else {
+    frame         = buffer;
+    frameWidth    = WIDTH;
+    frameHeight   = HEIGHT;
+    frameRotation = rotation;
+  }
+}
+
+// gfxTranspose8x8() on two matrices at once, one per 64-bit lane, plus
+// reversing the byte order within each lane
+#if defined(SSD1306_NEON)
+static inline uint8x16_t transpose8x8x2(uint8x16_t v) {
+  uint64x2_t m = vreinterpretq_u64_u8(v), t;
+  t = vandq_u64(veorq_u64(m, vshrq_n_u64(m,  7)),
+    vdupq_n_u64(0x00AA00AA00AA00AAULL));
+  m = veorq_u64(m, veorq_u64(t, vshlq_n_u64(t,  7)));
+  t = vandq_u64(veorq_u64(m, vshrq_n_u64(m, 14)),
+    vdupq_n_u64(0x0000CCCC0000CCCCULL));
+  m = veorq_u64(m, veorq_u64(t, vshlq_n_u64(t, 14)));
+  t = vandq_u64(veorq_u64(m, vshrq_n_u64(m, 28)),
+    vdupq_n_u64(0x00000000F0F0F0F0ULL));
+  m = veorq_u64(m, veorq_u64(t, vshlq_n_u64(t, 28)));
+  return vreinterpretq_u8_u64(m);
+}
+#define reverse8x2(v) vrev64q_u8(v)
+#elif defined(SSD1306_SSE2)
+static inline __m128i transpose8x8x2(__m128i m) {
+  __m128i t;
+  t = _mm_and_si128(_mm_xor_si128(m, _mm_srli_epi64(m,  7)),
+    _mm_set1_epi64x(0x00AA00AA00AA00AALL));
+  m = _mm_xor_si128(m, _mm_xor_si128(t, _mm_slli_epi64(t,  7)));
+  t = _mm_and_si128(_mm_xor_si128(m, _mm_srli_epi64(m, 14)),
+    _mm_set1_epi64x(0x0000CCCC0000CCCCLL));
+  m = _mm_xor_si128(m, _mm_xor_si128(t, _mm_slli_epi64(t, 14)));
+  t = _mm_and_si128(_mm_xor_si128(m, _mm_srli_epi64(m, 28)),
+    _mm_set1_epi64x(0x00000000F0F0F0F0LL));
+  m = _mm_xor_si128(m, _mm_xor_si128(t, _mm_slli_epi64(t, 28)));
+  return m;
+}
+static inline __m128i reverse8x2(__m128i m) {
+  m = _mm_shufflehi_epi16(_mm_shufflelo_epi16(m, 0x1B), 0x1B);
+  return _mm_or_si128(_mm_slli_epi16(m, 8), _mm_srli_epi16(m, 8));
+}
+#endif
+
+// Turn the logical-orientation scratch frame into the frame buffer.  The
+// scratch frame is frameWidth (= HEIGHT) columns by frameHeight (= WIDTH)
+// rows; an 8x8 block of it is 8 column bytes of one page and, transposed,
+// becomes 8 column bytes of the frame buffer.  Rotation 1 puts logical
+// (x, y) at (WIDTH-1-y, x): block (lx, page p) lands on page lx/8 at
+// columns WIDTH-1-8p downwards.  Rotation 3 puts it at (y, HEIGHT-1-x):
+// page (HEIGHT-8-lx)/8, columns 8p upwards, with the bits upside down,
+// which reversing the block's bytes before transposing takes care of.
+void Adafruit_SSD1306::rotateFrame(void) {
+  boolean cw = (rotation == 1);
+  for(int16_t p=0; p<frameHeight/8; p++) {
+    const uint8_t *src = &scratch[p * frameWidth];
+    int16_t        lx  = 0;
+#if defined(SSD1306_NEON)
+    for(; lx + 16 <= frameWidth; lx += 16) {
+      uint8x16_t v = vld1q_u8(&src[lx]);
+      uint8_t   *a, *b; // Destinations of blocks lx and lx + 8
+      if(cw) {
+        v = reverse8x2(transpose8x8x2(v));
+        a = &buffer[(lx / 8) * WIDTH + WIDTH - 8 - 8 * p];
+        b = a + WIDTH;
+      } else {
+        v = transpose8x8x2(reverse8x2(v));
+        a = &buffer[((HEIGHT - 8 - lx) / 8) * WIDTH + 8 * p];
+        b = a - WIDTH;
+      }
+      vst1_u8(a, vget_low_u8(v));
+      vst1_u8(b, vget_high_u8(v));
+    }
+#elif defined(SSD1306_SSE2)
+    for(; lx + 16 <= frameWidth; lx += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)&src[lx]);
+      uint8_t *a, *b; // Destinations of blocks lx and lx + 8
+      if(cw) {
+        v = reverse8x2(transpose8x8x2(v));
+        a = &buffer[(lx / 8) * WIDTH + WIDTH - 8 - 8 * p];
+        b = a + WIDTH;
+      } else {
+        v = transpose8x8x2(reverse8x2(v));
+        a = &buffer[((HEIGHT - 8 - lx) / 8) * WIDTH + 8 * p];
+        b = a - WIDTH;
+      }
+      _mm_storel_epi64((__m128i *)a, v);
+      _mm_storel_epi64((__m128i *)b, _mm_unpackhi_epi64(v, v));
+    }
+#endif
+    for(; lx < frameWidth; lx += 8) {
+      uint64_t m = 0;
+      for(uint8_t c=0; c<8; c++) {
+        m |= (uint64_t)src[lx + c] << ((cw ? c : 7 - c) * 8);
+      }
+      m = gfxTranspose8x8(m);
+      if(cw) {
+        uint8_t *dst = &buffer[(lx / 8) * WIDTH + WIDTH - 1 - 8 * p];
+        for(uint8_t r=0; r<8; r++) dst[-r] = m >> (r * 8);
+      } else {
+        uint8_t *dst = &buffer[((HEIGHT - 8 - lx) / 8) * WIDTH + 8 * p];
+        for(uint8_t r=0; r<8; r++) dst[r]  = m >> (r * 8);
+      }
+    }
+  }
+}
+
+// The inverse, frame buffer into scratch frame, for switching into deferred
+// rotation.  The transpose is its own inverse; only the byte order
+// differs.  Runs once per switch, not per frame, so it stays scalar.
+void Adafruit_SSD1306::unrotateFrame(void) {
+  boolean cw = (rotation == 1);
+  for(int16_t p=0; p<frameHeight/8; p++) {
+    uint8_t *dst = &scratch[p * frameWidth];
+    for(int16_t lx=0; lx<frameWidth; lx += 8) {
+      uint64_t m = 0;
+      if(cw) {
+        const uint8_t *src = &buffer[(lx / 8) * WIDTH + WIDTH - 1 - 8 * p];
+        for(uint8_t r=0; r<8; r++) m |= (uint64_t)src[-r] << (r * 8);
+      } else {
+        const uint8_t *src = &buffer[((HEIGHT - 8 - lx) / 8) * WIDTH + 8 * p];
+        for(uint8_t r=0; r<8; r++) m |= (uint64_t)src[r]  << (r * 8);
+      }
+      m = gfxTranspose8x8(m);
+      for(uint8_t c=0; c<8; c++) {
+        dst[lx + c] = m >> ((cw ? c : 7 - c) * 8);
+      }
+    }
+  }
+}
+
+// Hash of one SSD1306_CHUNK-byte chunk, over its four 32-bit words: a
+// CRC32C where the CPU has the instruction (SSE4.2, ARMv8 CRC), otherwise
+// each word through a bijective mix, XORed in at its own rotation.  Either
+// way a change confined to one word always changes the hash (no word value
+// makes another drop out, as with a product), and changes to several
+// words are missed about once in 2^32.
+static inline uint32_t chunkHash(const uint8_t *p) {
+  uint32_t w[4], h;
+  memcpy(w, p, sizeof w);
+#if defined(__SSE4_2__)
+  h = _mm_crc32_u32(_mm_crc32_u32(_mm_crc32_u32(_mm_crc32_u32(
+    0xFFFFFFFF, w[0]), w[1]), w[2]), w[3]);
+#elif defined(__ARM_FEATURE_CRC32)
+  h = __crc32cw(__crc32cw(__crc32cw(__crc32cw(0xFFFFFFFF, w[0]), w[1]), w[2]),
+    w[3]);
+#else
+  h = 0;
+  for (uint8_t i=0; i<4; i++) {
+    uint32_t m = w[i];      // MurmurHash3's finalizer: xorshifts and odd
+    m ^= m >> 16;           // multipliers, each invertible
+    m *= 0x85EBCA6BUL;
+    m ^= m >> 13;
+    m *= 0xC2B2AE35UL;
+    m ^= m >> 16;
+    h = ((h << 8) | (h >> 24)) ^ m;
+  }
+#endif
+  return h;
+}
+
+void Adafruit_SSD1306::invalidateDisplay(void) {
+  sentValid = false;
+}
+
+void Adafruit_SSD1306::resetDisplayStats(void) {
+  framesElided = pagesElided = chunksElided = 0;
+}
+
+uint32_t Adafruit_SSD1306::getFramesElided(void) const { return framesElided; }
+uint32_t Adafruit_SSD1306::getPagesElided(void) const { return pagesElided; }
+uint32_t Adafruit_SSD1306::getChunksElided(void) const { return chunksElided; }
+
+// Send n bytes of GDDRAM data at the current address
+void Adafruit_SSD1306::ssd1306_data(const uint8_t *p, uint16_t n) {
+  if (capture)
+  {
+    capture->data(p, n);
+  }
+  else if (sid != -1)
   {
     // SPI
 #ifdef HAVE_PORTREG
@@ -446,8 +710,8 @@ void Adafruit_SSD1306::display(void) {
     digitalWrite(cs, LOW);
 #endif
 
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      fastSPIwrite(buffer[i]);
+    while (n--) {
+      fastSPIwrite(*p++);
     }
 #ifdef HAVE_PORTREG
     *csport |= cspinmask;
@@ -457,36 +721,136 @@ void Adafruit_SSD1306::display(void) {
   }
   else
   {
-    // save I2C bitrate
-#ifdef TWBR
-    uint8_t twbrbackup = TWBR;
-    TWBR = 12; // upgrade to 400KHz!
-#endif
-
-    //Serial.println(TWBR, DEC);
-    //Serial.println(TWSR & 0x3, DEC);
-
     // I2C
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
+    while (n) {
       // send a bunch of data in one xmission
+      uint8_t len = (n < 16) ? n : 16;
       Wire.beginTransmission(_i2caddr);
       WIRE_WRITE(0x40);
-      for (uint8_t x=0; x<16; x++) {
-        WIRE_WRITE(buffer[i]);
-        i++;
+      for (uint8_t x=0; x<len; x++) {
+        WIRE_WRITE(*p++);
       }
-      i--;
       Wire.endTransmission();
+      n -= len;
+    }
+  }
+}
+
+// Address window for the following data, filled page by page
+void Adafruit_SSD1306::setWindow(uint8_t col0, uint8_t col1,
+                                 uint8_t page0, uint8_t page1) {
+  ssd1306_command(SSD1306_COLUMNADDR);
+  ssd1306_command(col0); // Column start address
+  ssd1306_command(col1); // Column end address
+  ssd1306_command(SSD1306_PAGEADDR);
+  ssd1306_command(page0); // Page start address
+  ssd1306_command(page1); // Page end address
+}
+
+void Adafruit_SSD1306::sendPages(uint8_t x, uint8_t page, uint8_t w,
+                                 uint8_t pages, const uint8_t *data) {
+  if(!w || !pages) return;
+  setWindow(x, x + w - 1, page, page + pages - 1);
+  ssd1306_data(data, (uint16_t)w * pages);
+  sentValid = false;
+}
+
+void Adafruit_SSD1306::setCapture(Adafruit_SSD1306_Capture *c) {
+  capture   = c;
+  sentValid = false;
+}
+
+void Adafruit_SSD1306::setMirror(Adafruit_SSD1306_Mirror *m) {
+  mirror    = m;
+  sentValid = false; // So the next display() publishes the whole frame
+}
+
+void Adafruit_SSD1306::setStartLine(uint8_t line) {
+  ssd1306_command(SSD1306_SETSTARTLINE | (line & 63));
+}
+
+void Adafruit_SSD1306::display(void) {
+  if(frame != buffer) rotateFrame();
+
+  const uint8_t perPage = SSD1306_LCDWIDTH / SSD1306_CHUNK,
+                pages   = SSD1306_LCDHEIGHT / 8;
+
+  // First and last changed chunk of each page, -1 if none
+  int8_t first[pages], last[pages];
+  boolean any = false;
+  for (uint8_t p=0, i=0; p<pages; p++) {
+    first[p] = last[p] = -1;
+    for (uint8_t c=0; c<perPage; c++, i++) {
+      uint32_t h = chunkHash(&buffer[i * SSD1306_CHUNK]);
+      if (!sentValid || (h != sentHash[i])) {
+        if (first[p] < 0) first[p] = c;
+        last[p] = c;
+        any = true;
+      }
+      sentHash[i] = h;
     }
+  }
+  sentValid = true;
+
+  if (!any) {
+    framesElided++;
+    pagesElided  += pages;
+    chunksElided += SSD1306_CHUNKS;
+    if(capture) capture->frame();
+    return;
+  }
+
+  // save I2C bitrate
 #ifdef TWBR
-    TWBR = twbrbackup;
+  uint8_t twbrbackup = TWBR;
+  if (sid == -1) TWBR = 12; // upgrade to 400KHz!
 #endif
+
+  if (mirror) {
+    uint8_t changed = 0;
+    for (uint8_t p=0; p<pages; p++)
+      if (first[p] >= 0) changed |= 1 << p;
+    mirror->publish(buffer, changed);
   }
+
+  for (uint8_t p=0; p<pages; ) {
+    if (first[p] < 0) {
+      pagesElided++;
+      chunksElided += perPage;
+      p++;
+      continue;
+    }
+    // Following pages with the same span join this page's window
+    uint8_t q = p;
+    while ((q+1 < pages) && (first[q+1] == first[p]) && (last[q+1] == last[p]))
+      q++;
+
+    uint8_t  col = first[p] * SSD1306_CHUNK;
+    uint16_t len = (last[p] - first[p] + 1) * SSD1306_CHUNK;
+    chunksElided += (uint32_t)(perPage - len / SSD1306_CHUNK) * (q - p + 1);
+
+    setWindow(col, col + len - 1, p, q);
+
+    // The window is filled page by page, so with full-width spans this is
+    // one contiguous run
+    if (len == SSD1306_LCDWIDTH) {
+      ssd1306_data(&buffer[p * SSD1306_LCDWIDTH], (q - p + 1) * len);
+    } else {
+      for (uint8_t r=p; r<=q; r++)
+        ssd1306_data(&buffer[r * SSD1306_LCDWIDTH + col], len);
+    }
+    p = q + 1;
+  }
+
+#ifdef TWBR
+  TWBR = twbrbackup;
+#endif
+  if(capture) capture->frame();
 }
 
 // clear everything
 void Adafruit_SSD1306::clearDisplay(void) {
-  memset(buffer, 0, (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8));
+  memset(frame, 0, (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8));
 }
 
 
@@ -513,7 +877,7 @@ inline void Adafruit_SSD1306::fastSPIwrite(uint8_t d) {
 
 void Adafruit_SSD1306::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
   boolean bSwap = false;
-  switch(rotation) {
+  switch(frameRotation) {
     case 0:
       // 0 degree rotation, do nothing
       break;
@@ -547,7 +911,7 @@ void Adafruit_SSD1306::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t c
 
 void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color) {
   // Do bounds/limit checks
-  if(y < 0 || y >= HEIGHT) { return; }
+  if(y < 0 || y >= frameHeight) { return; }
 
   // make sure we don't try to draw below 0
   if(x < 0) {
@@ -556,17 +920,17 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
   }
 
   // make sure we don't go off the edge of the display
-  if( (x + w) > WIDTH) {
-    w = (WIDTH - x);
+  if( (x + w) > frameWidth) {
+    w = (frameWidth - x);
   }
 
   // if our width is now negative, punt
   if(w <= 0) { return; }
 
   // set up the pointer for  movement through the buffer
-  register uint8_t *pBuf = buffer;
+  register uint8_t *pBuf = frame;
   // adjust the buffer pointer for the current row
-  pBuf += ((y/8) * SSD1306_LCDWIDTH);
+  pBuf += ((y/8) * frameWidth);
   // and offset x columns in
   pBuf += x;
 
@@ -582,7 +946,7 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
 
 void Adafruit_SSD1306::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
   bool bSwap = false;
-  switch(rotation) {
+  switch(frameRotation) {
     case 0:
       break;
     case 1:
@@ -617,7 +981,7 @@ void Adafruit_SSD1306::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t c
 void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h, uint16_t color) {
 
   // do nothing if we're off the left or right side of the screen
-  if(x < 0 || x >= WIDTH) { return; }
+  if(x < 0 || x >= frameWidth) { return; }
 
   // make sure we don't try to draw below 0
   if(__y < 0) {
@@ -628,8 +992,8 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
   }
 
   // make sure we don't go past the height of the display
-  if( (__y + __h) > HEIGHT) {
-    __h = (HEIGHT - __y);
+  if( (__y + __h) > frameHeight) {
+    __h = (frameHeight - __y);
   }
 
   // if our height is now negative, punt
@@ -643,9 +1007,9 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
 
 
   // set up the pointer for fast movement through the buffer
-  register uint8_t *pBuf = buffer;
+  register uint8_t *pBuf = frame;
   // adjust the buffer pointer for the current row
-  pBuf += ((y/8) * SSD1306_LCDWIDTH);
+  pBuf += ((y/8) * frameWidth);
   // and offset x columns in
   pBuf += x;
 
@@ -677,7 +1041,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
 
     h -= mod;
 
-    pBuf += SSD1306_LCDWIDTH;
+    pBuf += frameWidth;
   }
 
 
@@ -688,7 +1052,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
       *pBuf=~(*pBuf);
 
         // adjust the buffer forward 8 rows worth of data
-        pBuf += SSD1306_LCDWIDTH;
+        pBuf += frameWidth;
 
         // adjust h & y (there's got to be a faster way for me to do this, but this should still help a fair bit for now)
         h -= 8;
@@ -703,7 +1067,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
       *pBuf = val;
 
         // adjust the buffer forward 8 rows worth of data
-        pBuf += SSD1306_LCDWIDTH;
+        pBuf += frameWidth;
 
         // adjust h & y (there's got to be a faster way for me to do this, but this should still help a fair bit for now)
         h -= 8;
@@ -727,3 +1091,286 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
     }
   }
 }
+
+void Adafruit_SSD1306::drawChar(int16_t x, int16_t y, unsigned char c,
+ uint16_t color, uint16_t bg, uint8_t size) {
+  // Classic font, a regular row-major font set with setFont(), or a page
+  // font scaled or rotated (no byte alignment to exploit): per pixel
+  if(!pageFont || (size != 1) || (frameRotation != 0)) {
+    Adafruit_GFX::drawChar(x, y, c, color, bg, size);
+    return;
+  }
+
+  c -= pgm_read_byte(&gfxFont->first);
+  GFXglyph *glyph  = &(((GFXglyph *)pgm_read_pointer(&gfxFont->glyph))[c]);
+  uint8_t  *bitmap = (uint8_t *)pgm_read_pointer(&gfxFont->bitmap);
+
+  uint16_t bo = pgm_read_word(&glyph->bitmapOffset);
+  uint8_t  w  = pgm_read_byte(&glyph->width),
+           h  = pgm_read_byte(&glyph->height);
+  int8_t   xo = pgm_read_byte(&glyph->xOffset),
+           yo = pgm_read_byte(&glyph->yOffset);
+  uint8_t  pages = (h + 7) / 8;
+
+  // Each source byte lands in at most two frame buffer pages: shifted up
+  // by the glyph's y phase into one, the remainder into the next.
+  int16_t x0 = x + xo, y0 = y + yo;
+  int16_t i0 = 0, i1 = w;
+  if(x0 < 0)                  i0 = -x0;
+  if(x0 + i1 > frameWidth)    i1 = frameWidth - x0;
+  if(i0 >= i1) return;
+
+  int16_t page  = y0 >> 3; // floor, also for negative y0
+  uint8_t shift = y0 & 7;
+
+  for(uint8_t p=0; p<pages; p++, page++) {
+    if(page >= frameHeight / 8) break;
+    const uint8_t *src = &bitmap[bo + p * w];
+    uint8_t       *lo  = ((page >= 0) && (page < frameHeight / 8)) ?
+      &frame[page * frameWidth + x0] : NULL;
+    uint8_t       *hi  = (shift && (page + 1 >= 0) &&
+      (page + 1 < frameHeight / 8)) ?
+      &frame[(page + 1) * frameWidth + x0] : NULL;
+
+    if(lo) {
+      switch(color) {
+       case WHITE:   for(int16_t i=i0; i<i1; i++) lo[i] |=  (uint8_t)(pgm_read_byte(&src[i]) << shift); break;
+       case BLACK:   for(int16_t i=i0; i<i1; i++) lo[i] &= ~(uint8_t)(pgm_read_byte(&src[i]) << shift); break;
+       case INVERSE: for(int16_t i=i0; i<i1; i++) lo[i] ^=  (uint8_t)(pgm_read_byte(&src[i]) << shift); break;
+      }
+    }
+    if(hi) {
+      uint8_t rshift = 8 - shift;
+      switch(color) {
+       case WHITE:   for(int16_t i=i0; i<i1; i++) hi[i] |=  (uint8_t)(pgm_read_byte(&src[i]) >> rshift); break;
+       case BLACK:   for(int16_t i=i0; i<i1; i++) hi[i] &= ~(uint8_t)(pgm_read_byte(&src[i]) >> rshift); break;
+       case INVERSE: for(int16_t i=i0; i<i1; i++) hi[i] ^=  (uint8_t)(pgm_read_byte(&src[i]) >> rshift); break;
+      }
+    }
+  }
+}
+
+// 8x8 Bayer matrix, pre-scaled to luminance thresholds (4n + 2)
+static const uint8_t bayer8[8][8] = {
+  {   2, 130,  34, 162,  10, 138,  42, 170 },
+  { 194,  66, 226,  98, 202,  74, 234, 106 },
+  {  50, 178,  18, 146,  58, 186,  26, 154 },
+  { 242, 114, 210,  82, 250, 122, 218,  90 },
+  {  14, 142,  46, 174,   6, 134,  38, 166 },
+  { 206,  78, 238, 110, 198,  70, 230, 102 },
+  {  62, 190,  30, 158,  54, 182,  22, 150 },
+  { 254, 126, 222,  94, 246, 118, 214,  86 }
+};
+
+// RGB565 to 8-bit luminance, Y = .30R + .59G + .11B.  The weights are
+// pre-divided for the 5/6/5 bit fields, so one multiply-add per channel
+// does it in 16 bits: 31*633 + 63*607 + 31*239 + 255 < 65536.
+#define SSD1306_LUMA(p) \
+  ((((p) >> 11) * 633 + (((p) >> 5) & 0x3F) * 607 + ((p) & 0x1F) * 239 \
+    + 255) >> 8)
+
+// Luminance of 'n' pixels, 8 at a time where SIMD is available
+static void lumaRow(const uint16_t *src, uint8_t *dst, int16_t n) {
+  int16_t i = 0;
+#if defined(SSD1306_NEON)
+  for(; i + 8 <= n; i += 8) {
+    uint16x8_t p = vld1q_u16(&src[i]);
+    uint16x8_t y = vmulq_n_u16(vshrq_n_u16(p, 11), 633);
+    y = vmlaq_n_u16(y, vandq_u16(vshrq_n_u16(p, 5), vdupq_n_u16(0x3F)), 607);
+    y = vmlaq_n_u16(y, vandq_u16(p, vdupq_n_u16(0x1F)), 239);
+    y = vaddq_u16(y, vdupq_n_u16(255));
+    vst1_u8(&dst[i], vshrn_n_u16(y, 8));
+  }
+#elif defined(SSD1306_SSE2)
+  const __m128i m6 = _mm_set1_epi16(0x3F), m5 = _mm_set1_epi16(0x1F),
+                wr = _mm_set1_epi16(633), wg = _mm_set1_epi16(607),
+                wb = _mm_set1_epi16(239), rnd = _mm_set1_epi16(255);
+  for(; i + 8 <= n; i += 8) {
+    __m128i p = _mm_loadu_si128((const __m128i *)&src[i]);
+    __m128i y = _mm_mullo_epi16(_mm_srli_epi16(p, 11), wr);
+    y = _mm_add_epi16(y, _mm_mullo_epi16(
+          _mm_and_si128(_mm_srli_epi16(p, 5), m6), wg));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(_mm_and_si128(p, m5), wb));
+    y = _mm_srli_epi16(_mm_add_epi16(y, rnd), 8);
+    _mm_storel_epi64((__m128i *)&dst[i], _mm_packus_epi16(y, y));
+  }
+#endif
+  for(; i < n; i++) dst[i] = SSD1306_LUMA(src[i]);
+}
+
+// Luminance compared against a threshold pattern repeating every 8
+// pixels (one Bayer row, or all the same for plain thresholding).
+// Writes 0xFF for white, 0x00 for black.
+static void thresholdRow(const uint16_t *src, uint8_t *dst, int16_t n,
+ const uint8_t *pattern) {
+  int16_t i = 0;
+#if defined(SSD1306_NEON)
+  uint16x8_t t = vmovl_u8(vld1_u8(pattern));
+  for(; i + 8 <= n; i += 8) {
+    uint16x8_t p = vld1q_u16(&src[i]);
+    uint16x8_t y = vmulq_n_u16(vshrq_n_u16(p, 11), 633);
+    y = vmlaq_n_u16(y, vandq_u16(vshrq_n_u16(p, 5), vdupq_n_u16(0x3F)), 607);
+    y = vmlaq_n_u16(y, vandq_u16(p, vdupq_n_u16(0x1F)), 239);
+    y = vshrq_n_u16(vaddq_u16(y, vdupq_n_u16(255)), 8);
+    vst1_u8(&dst[i], vmovn_u16(vcgtq_u16(y, t)));
+  }
+#elif defined(SSD1306_SSE2)
+  const __m128i m6 = _mm_set1_epi16(0x3F), m5 = _mm_set1_epi16(0x1F),
+                wr = _mm_set1_epi16(633), wg = _mm_set1_epi16(607),
+                wb = _mm_set1_epi16(239), rnd = _mm_set1_epi16(255),
+                t  = _mm_unpacklo_epi8(
+                       _mm_loadl_epi64((const __m128i *)pattern),
+                       _mm_setzero_si128());
+  for(; i + 8 <= n; i += 8) {
+    __m128i p = _mm_loadu_si128((const __m128i *)&src[i]);
+    __m128i y = _mm_mullo_epi16(_mm_srli_epi16(p, 11), wr);
+    y = _mm_add_epi16(y, _mm_mullo_epi16(
+          _mm_and_si128(_mm_srli_epi16(p, 5), m6), wg));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(_mm_and_si128(p, m5), wb));
+    y = _mm_srli_epi16(_mm_add_epi16(y, rnd), 8);
+    __m128i on = _mm_cmpgt_epi16(y, t); // Both 0..255, signed compare is fine
+    _mm_storel_epi64((__m128i *)&dst[i], _mm_packs_epi16(on, on));
+  }
+#endif
+  for(; i < n; i++) {
+    dst[i] = (SSD1306_LUMA(src[i]) > pattern[i & 7]) ? 0xFF : 0x00;
+  }
+}
+
+void Adafruit_SSD1306::drawRGB565(int16_t x, int16_t y,
+ const uint16_t *bitmap, int16_t w, int16_t h, uint8_t dither) {
+  // Clip against the (rotated) display, remembering where in the source
+  // each output row and column starts
+  int16_t sx = 0, sy = 0, stride = w;
+  if(x < 0) { sx = -x; w += x; x = 0; }
+  if(y < 0) { sy = -y; h += y; y = 0; }
+  if(x + w > width())  w = width()  - x;
+  if(y + h > height()) h = height() - y;
+  if((w <= 0) || (h <= 0)) return;
+  bitmap += (int32_t)sy * stride + sx;
+
+  uint8_t  bits[SSD1306_LCDWIDTH > SSD1306_LCDHEIGHT ?
+                SSD1306_LCDWIDTH : SSD1306_LCDHEIGHT],
+           pattern[8];
+  int16_t  err[2][(SSD1306_LCDWIDTH > SSD1306_LCDHEIGHT ?
+                   SSD1306_LCDWIDTH : SSD1306_LCDHEIGHT) + 2];
+  int16_t *cur = err[0], *next = err[1];
+
+  if(dither == SSD1306_DITHER_DIFFUSION) memset(err, 0, sizeof(err));
+  else if(dither != SSD1306_DITHER_ORDERED) memset(pattern, 127, 8);
+
+  for(int16_t j=0; j<h; j++, bitmap += stride) {
+    // One row of 0x00/0xFF pixel values into bits[]
+    if(dither == SSD1306_DITHER_DIFFUSION) {
+      // Floyd-Steinberg: 7/16 right, 3/16 down-left, 5/16 down,
+      // 1/16 down-right.  err[] rows are offset by one so the edge
+      // columns need no special case.
+      lumaRow(bitmap, bits, w);
+      memset(next, 0, (w + 2) * sizeof(int16_t));
+      for(int16_t i=0; i<w; i++) {
+        int16_t v = bits[i] + cur[i + 1], e;
+        if(v >= 128) {
+          bits[i] = 0xFF;
+          e       = v - 255;
+        } else {
+          bits[i] = 0x00;
+          e       = v;
+        }
+        cur[i + 2]  += (e * 7) / 16;
+        next[i]     += (e * 3) / 16;
+        next[i + 1] += (e * 5) / 16;
+        next[i + 2] +=  e      / 16;
+      }
+      int16_t *t = cur; cur = next; next = t;
+    } else {
+      if(dither == SSD1306_DITHER_ORDERED) {
+        // Lane k of each 8-pixel group is screen column x + 8n + k
+        for(uint8_t k=0; k<8; k++) pattern[k] = bayer8[(y + j) & 7][(x + k) & 7];
+      }
+      thresholdRow(bitmap, bits, w, pattern);
+    }
+
+    if(frameRotation == 0) {
+      // Unrotated: each row is one bit in a run of frame buffer bytes
+      uint8_t *dst  = &frame[((y + j) / 8) * frameWidth + x];
+      uint8_t  mask = 1 << ((y + j) & 7);
+      for(int16_t i=0; i<w; i++) {
+        dst[i] = (dst[i] & ~mask) | (bits[i] & mask);
+      }
+    } else {
+      for(int16_t i=0; i<w; i++) {
+        drawPixel(x + i, y + j, bits[i] ? WHITE : BLACK);
+      }
+    }
+  }
+}
+
+void Adafruit_SSD1306::drawCanvas16(int16_t x, int16_t y,
+ GFXcanvas16 &canvas, uint8_t dither) {
+  // The canvas buffer is always in its unrotated orientation
+  boolean swap = canvas.getRotation() & 1;
+  drawRGB565(x, y, canvas.getBuffer(),
+    swap ? canvas.height() : canvas.width(),
+    swap ? canvas.width()  : canvas.height(), dither);
+}
+
+GFXsurface Adafruit_SSD1306::getSurface(void) {
+  GFXsurface s = { frame, frameWidth, frameHeight, GFX_LAYOUT_PAGES };
+  return s;
+}
+
+void Adafruit_SSD1306::drawCanvas(int16_t x, int16_t y,
+ GFXcanvasPage &canvas) {
+  const uint8_t *src = canvas.getBuffer();
+  if(!src) return;
+
+  // The canvas buffer is always in its unrotated orientation
+  boolean swap = canvas.getRotation() & 1;
+  int16_t w = swap ? canvas.height() : canvas.width(),
+          h = swap ? canvas.width()  : canvas.height(),
+          stride = w;
+
+  if(frameRotation != 0) {
+    for(int16_t j=0; j<h; j++) {
+      for(int16_t i=0; i<w; i++) {
+        drawPixel(x + i, y + j,
+          (src[i + (j / 8) * stride] & (1 << (j & 7))) ? WHITE : BLACK);
+      }
+    }
+    return;
+  }
+
+  // Clip columns; rows are clipped page by page below
+  if(x < 0) { src -= x; w += x; x = 0; }
+  if(x + w > frameWidth) w = frameWidth - x;
+  if(w <= 0) return;
+
+  int16_t top    = (y < 0) ? 0 : y,
+          bottom = (y + h > frameHeight) ? frameHeight : y + h,
+          pages  = (h + 7) / 8;
+  for(int16_t row = top & ~7; row < bottom; row += 8) {
+    // Rows of this display page that the canvas covers
+    uint8_t mask = 0xFF;
+    if(top > row)        mask &= 0xFF << (top - row);
+    if(bottom < row + 8) mask &= 0xFF >> (row + 8 - bottom);
+
+    // Canvas row at the top of this page: source page sp, bit shift sh
+    int16_t  off = row - y,
+             sp  = (off + 8) / 8 - 1,
+             sh  = off - sp * 8;
+    uint8_t *dst = &frame[x + (row / 8) * frameWidth];
+    const uint8_t *lo = (sp >= 0)        ? &src[sp * stride]       : NULL,
+                  *hi = (sp + 1 < pages) ? &src[(sp + 1) * stride] : NULL;
+
+    if(!sh && (mask == 0xFF)) {
+      memcpy(dst, lo, w);
+    } else {
+      for(int16_t i=0; i<w; i++) {
+        uint8_t v = 0;
+        if(lo)       v  = lo[i] >> sh;
+        if(hi && sh) v |= hi[i] << (8 - sh);
+        dst[i] = (dst[i] & ~mask) | (v & mask);
+      }
+    }
+  }
+}
@@ -91,6 +91,10 @@ All text above, and the splash screen must be included in any redistribution
   #define SSD1306_LCDHEIGHT                 16
 #endif
 
+// display() hashes the frame in chunks of this many bytes (within a page)
+#define SSD1306_CHUNK   16
+#define SSD1306_CHUNKS  (SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8 / SSD1306_CHUNK)
+
 #define SSD1306_SETCONTRAST 0x81
 #define SSD1306_DISPLAYALLON_RESUME 0xA4
 #define SSD1306_DISPLAYALLON 0xA5
@@ -137,11 +141,20 @@ All text above, and the splash screen must be included in any redistribution
 #define SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29
 #define SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL 0x2A
 
+class Adafruit_SSD1306_Capture;
+class Adafruit_SSD1306_Mirror;
+
+// drawRGB565() dithering modes
+#define SSD1306_DITHER_NONE      0 // Plain 50% luminance threshold
+#define SSD1306_DITHER_ORDERED   1 // 8x8 Bayer matrix
+#define SSD1306_DITHER_DIFFUSION 2 // Floyd-Steinberg error diffusion
+
 class Adafruit_SSD1306 : public Adafruit_GFX {
  public:
   Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS);
   Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS);
   Adafruit_SSD1306(int8_t RST = -1);
+  ~Adafruit_SSD1306(void);
 
   void begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = SSD1306_I2C_ADDRESS, bool reset=true);
   void ssd1306_command(uint8_t c);
@@ -150,6 +163,42 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
   void invertDisplay(uint8_t i);
   void display();
 
+  // display() only sends what changed since the previous display(): each
+  // 16-byte chunk of a page is hashed and compared with the hash of what
+  // was sent, and each page's span from its first to its last changed
+  // chunk goes out in one address window (pages with equal spans share a
+  // window).  An unchanged frame sends nothing.  begin() and
+  // invalidateDisplay() force the next display() to send everything, e.g.
+  // after writing GDDRAM some other way.  The counters tell how much was
+  // skipped: whole frames, pages, and chunks (including those of skipped
+  // pages and frames).
+  void     invalidateDisplay(void);
+  void     resetDisplayStats(void);
+  uint32_t getFramesElided(void) const;
+  uint32_t getPagesElided(void) const;
+  uint32_t getChunksElided(void) const;
+
+  // Write page-layout data (w bytes per page, 'pages' pages back to back)
+  // straight into GDDRAM at column x, page 'page', bypassing the frame
+  // buffer; the next display() then sends everything.  setStartLine()
+  // picks the GDDRAM row (0-63, wrapping) shown at the top of the panel.
+  // These are for widgets that drive the panel themselves, such as
+  // Adafruit_SSD1306_Console.
+  void sendPages(uint8_t x, uint8_t page, uint8_t w, uint8_t pages,
+    const uint8_t *data);
+  void setStartLine(uint8_t line);
+
+  // Send commands and data to an emulated panel instead of the bus, to run
+  // headless (see Adafruit_SSD1306_Capture.h); every display() then ends
+  // a captured frame.  Set it before begin(), which then leaves pins and
+  // bus alone.  NULL goes back to the bus.
+  void setCapture(Adafruit_SSD1306_Capture *capture);
+
+  // Also publish each display()ed frame (the pages that changed) to a
+  // shared-memory mirror for other processes; NULL stops.  See
+  // Adafruit_SSD1306_Mirror.h.
+  void setMirror(Adafruit_SSD1306_Mirror *mirror);
+
   void startscrollright(uint8_t start, uint8_t stop);
   void startscrollleft(uint8_t start, uint8_t stop);
 
@@ -159,14 +208,68 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   void dim(boolean dim);
 
+  // Panels mounted sideways: with deferred rotation on and rotation 1 or 3,
+  // drawing goes unrotated into a scratch frame in the logical orientation
+  // (so horizontal lines stay horizontal runs of bytes) and display()
+  // rotates the whole frame with 8x8 bit transposes.  Costs a second frame
+  // of RAM; returns false if that can't be had.  The frame buffer proper
+  // then only holds the last displayed image.  Turning deferral on or off
+  // and changing rotation keep what has been drawn, at the cost of one
+  // rotation of the whole frame per switch.
+  boolean setDeferredRotation(boolean enable);
+  void    setRotation(uint8_t r);
+
   void drawPixel(int16_t x, int16_t y, uint16_t color);
 
   virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
 
+  // Fonts converted with 'fontconvert -p' store glyphs in the frame buffer's
+  // own page layout and are drawn with whole-byte ORs (or AND/XOR for
+  // BLACK/INVERSE) at any x/y.  Select one with setPageFont() instead of
+  // setFont(); metrics, cursor handling and getTextBounds() are unchanged.
+  virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+    uint16_t bg, uint8_t size);
+
+  // Convert 16-bit RGB565 pixels (row-major, w x h, e.g. a GFXcanvas16) to
+  // black and white by luminance with the chosen dithering, straight into
+  // the frame buffer.  Pixels are both set and cleared.
+  void drawRGB565(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w,
+    int16_t h, uint8_t dither = SSD1306_DITHER_ORDERED);
+  void drawCanvas16(int16_t x, int16_t y, GFXcanvas16 &canvas,
+    uint8_t dither = SSD1306_DITHER_ORDERED);
+
+  // Copy a page-layout canvas (set and clear pixels alike) into the frame
+  // buffer.  Unrotated and with y a multiple of 8 this is one memcpy per
+  // page; any other y shifts each column byte across two pages.
+  void drawCanvas(int16_t x, int16_t y, GFXcanvasPage &canvas);
+
+  // The frame being drawn into as a gfxBlit() surface (page layout): the
+  // frame buffer, or the logical-orientation scratch frame while rotation
+  // is deferred
+  GFXsurface getSurface(void);
+
  private:
   int8_t _i2caddr, _vccstate, sid, sclk, dc, rst, cs;
   void fastSPIwrite(uint8_t c);
+  void ssd1306_data(const uint8_t *p, uint16_t n);
+  void setWindow(uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1);
+
+  Adafruit_SSD1306_Capture *capture;
+  Adafruit_SSD1306_Mirror  *mirror;
+
+  uint32_t sentHash[SSD1306_CHUNKS]; // Hash of each chunk as last sent
+  boolean  sentValid;                // sentHash[] matches GDDRAM
+  uint32_t framesElided, pagesElided, chunksElided;
+
+  uint8_t *scratch,          // Logical-orientation frame, if deferring
+          *frame;            // Drawing target: frame buffer or scratch
+  int16_t  frameWidth,       // Target size in pixels; the page stride
+           frameHeight;      //  is frameWidth bytes
+  uint8_t  frameRotation;    // Rotation still applied while drawing
+  void selectFrame(void);
+  void rotateFrame(void);
+  void unrotateFrame(void);
 
   boolean hwSPI;
 #ifdef HAVE_PORTREG
@@ -0,0 +1,352 @@
+/*********************************************************************
+Emulated SSD1306 panel: decodes the command and data stream into GDDRAM
+and captures each displayed frame, optionally to PBM or PNG files.  See
+Adafruit_SSD1306_Capture.h for usage.
+*********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "Adafruit_SSD1306_Capture.h"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+ #include <stdio.h>
+ #define SSD1306_CAPTURE_FILES
+#endif
+
+#define FRAME_BYTES (SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8)
+
+Adafruit_SSD1306_Capture::Adafruit_SSD1306_Capture(uint16_t k) {
+  keep   = k ? k : 1;
+  frames = (uint8_t *)malloc((size_t)keep * FRAME_BYTES);
+  stamps = (uint32_t *)malloc(keep * sizeof(uint32_t));
+  if(!frames || !stamps) {
+    free(frames); free(stamps);
+    frames = NULL; stamps = NULL;
+  }
+  frameCount = commandBytes = dataBytes = 0;
+  dumpPath   = NULL;
+  memset(ram, 0, sizeof ram);
+
+  // Reset state
+  nArgs = wantArgs = 0;
+  col = colStart = 0; colEnd = 127;
+  page = pageStart = 0; pageEnd = 7;
+  memoryMode = 2; // Page addressing
+  startLine = offset = 0;
+  mux = 64;
+  segRemap = comScanDec = inverted = allOn = on = false;
+}
+
+Adafruit_SSD1306_Capture::~Adafruit_SSD1306_Capture(void) {
+  free(frames);
+  free(stamps);
+  free(dumpPath);
+}
+
+void Adafruit_SSD1306_Capture::command(uint8_t c) {
+  commandBytes++;
+
+  if(nArgs < wantArgs) { // Argument of a multi-byte command
+    args[nArgs++] = c;
+    if(nArgs < wantArgs) return;
+    switch(args[0]) {
+      case SSD1306_MEMORYMODE:
+        memoryMode = args[1] & 3;
+        break;
+      case SSD1306_COLUMNADDR:
+        col = colStart = args[1] & 127;
+        colEnd = args[2] & 127;
+        break;
+      case SSD1306_PAGEADDR:
+        page = pageStart = args[1] & 7;
+        pageEnd = args[2] & 7;
+        break;
+      case SSD1306_SETMULTIPLEX:
+        mux = (args[1] & 63) + 1;
+        break;
+      case SSD1306_SETDISPLAYOFFSET:
+        offset = args[1] & 63;
+        break;
+    }
+    nArgs = wantArgs = 0;
+    return;
+  }
+
+  uint8_t n = 0; // Arguments that follow
+  switch(c) {
+    case SSD1306_SETCONTRAST:
+    case SSD1306_MEMORYMODE:
+    case SSD1306_SETMULTIPLEX:
+    case SSD1306_SETDISPLAYOFFSET:
+    case SSD1306_SETDISPLAYCLOCKDIV:
+    case SSD1306_SETPRECHARGE:
+    case SSD1306_SETCOMPINS:
+    case SSD1306_SETVCOMDETECT:
+    case SSD1306_CHARGEPUMP:
+      n = 1; break;
+    case SSD1306_COLUMNADDR:
+    case SSD1306_PAGEADDR:
+    case SSD1306_SET_VERTICAL_SCROLL_AREA:
+      n = 2; break;
+    case SSD1306_RIGHT_HORIZONTAL_SCROLL:
+    case SSD1306_LEFT_HORIZONTAL_SCROLL:
+      n = 6; break;
+    case SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL:
+    case SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL:
+      n = 5; break;
+  }
+  if(n) {
+    args[0]  = c;
+    nArgs    = 1;
+    wantArgs = n + 1;
+    return;
+  }
+
+  if(c <= 0x0F) {                          // Page mode column, low nibble
+    col = (col & 0xF0) | c;
+  } else if(c <= 0x1F) {                   // ...high nibble
+    col = (col & 0x0F) | ((c & 0x07) << 4);
+  } else if((c & 0xC0) == 0x40) {          // SETSTARTLINE
+    startLine = c & 63;
+  } else if((c & 0xF8) == 0xB0) {          // Page mode page
+    page = c & 7;
+  } else switch(c) {
+    case SSD1306_SEGREMAP:                 segRemap   = false; break;
+    case SSD1306_SEGREMAP | 1:             segRemap   = true;  break;
+    case SSD1306_COMSCANINC:               comScanDec = false; break;
+    case SSD1306_COMSCANDEC:               comScanDec = true;  break;
+    case SSD1306_DISPLAYALLON_RESUME:      allOn      = false; break;
+    case SSD1306_DISPLAYALLON:             allOn      = true;  break;
+    case SSD1306_NORMALDISPLAY:            inverted   = false; break;
+    case SSD1306_INVERTDISPLAY:            inverted   = true;  break;
+    case SSD1306_DISPLAYOFF:               on         = false; break;
+    case SSD1306_DISPLAYON:                on         = true;  break;
+  }
+}
+
+void Adafruit_SSD1306_Capture::data(const uint8_t *p, uint16_t n) {
+  dataBytes += n;
+  while(n--) {
+    ram[page * 128 + col] = *p++;
+    switch(memoryMode) {
+      case 0: // Horizontal: along the window's columns, then next page
+        if(col++ >= colEnd) {
+          col = colStart;
+          if(page++ >= pageEnd) page = pageStart;
+        }
+        break;
+      case 1: // Vertical: down the window's pages, then next column
+        if(page++ >= pageEnd) {
+          page = pageStart;
+          if(col++ >= colEnd) col = colStart;
+        }
+        break;
+      default: // Page: along the page, wrapping
+        col = (col + 1) & 127;
+        break;
+    }
+  }
+}
+
+// The image on the panel, in frame buffer layout.  The upright orientation
+// is that of begin(): column and COM scan both remapped.
+void Adafruit_SSD1306_Capture::render(uint8_t *dst) const {
+  memset(dst, 0, FRAME_BYTES);
+  if(!on) return;
+  if(allOn) {
+    memset(dst, 0xFF, FRAME_BYTES);
+    return;
+  }
+
+  uint8_t top = startLine + offset;
+  if(segRemap && comScanDec && (mux >= SSD1306_LCDHEIGHT) && !(top & 7)) {
+    // Whole pages
+    for(uint8_t p=0; p<SSD1306_LCDHEIGHT/8; p++)
+      memcpy(&dst[p * SSD1306_LCDWIDTH],
+        &ram[(((top >> 3) + p) & 7) * 128], SSD1306_LCDWIDTH);
+  } else {
+    for(uint8_t y=0; (y<SSD1306_LCDHEIGHT) && (y<mux); y++) {
+      uint8_t row = (top + (comScanDec ? y : mux - 1 - y)) & 63;
+      for(uint8_t x=0; x<SSD1306_LCDWIDTH; x++) {
+        uint8_t c = segRemap ? x : SSD1306_LCDWIDTH - 1 - x;
+        if(ram[(row >> 3) * 128 + c] & (1 << (row & 7)))
+          dst[(y >> 3) * SSD1306_LCDWIDTH + x] |= 1 << (y & 7);
+      }
+    }
+  }
+
+  if(inverted) {
+    for(uint16_t i=0; i<FRAME_BYTES; i++) dst[i] ^= 0xFF;
+  }
+}
+
+void Adafruit_SSD1306_Capture::frame(void) {
+  if(!frames) return;
+  uint16_t slot = frameCount % keep;
+  render(&frames[(size_t)slot * FRAME_BYTES]);
+  stamps[slot] = micros();
+  frameCount++;
+
+#ifdef SSD1306_CAPTURE_FILES
+  if(dumpPath) {
+    char   name[256];
+    snprintf(name, sizeof name, dumpPath, (unsigned long)(frameCount - 1));
+    size_t len = strlen(name);
+    if((len > 4) && !strcmp(&name[len - 4], ".png")) writePNG(name);
+    else                                              writePBM(name);
+  }
+#endif
+}
+
+const uint8_t *Adafruit_SSD1306_Capture::getFrame(uint16_t back,
+  uint32_t *us) const {
+  if(!frames || (back >= keep) || (back >= frameCount)) return NULL;
+  uint16_t slot = (frameCount - 1 - back) % keep;
+  if(us) *us = stamps[slot];
+  return &frames[(size_t)slot * FRAME_BYTES];
+}
+
+uint32_t Adafruit_SSD1306_Capture::getFrameCount(void) const {
+  return frameCount;
+}
+
+const uint8_t *Adafruit_SSD1306_Capture::getGDDRAM(void) const {
+  return ram;
+}
+
+uint32_t Adafruit_SSD1306_Capture::getCommandBytes(void) const {
+  return commandBytes;
+}
+
+uint32_t Adafruit_SSD1306_Capture::getDataBytes(void) const {
+  return dataBytes;
+}
+
+// Dump every captured frame to a file named by the printf pattern, which
+// gets the frame number (unsigned long); ".png" selects PNG, anything else
+// PBM.  NULL stops dumping.
+boolean Adafruit_SSD1306_Capture::setDumpPath(const char *pattern) {
+  free(dumpPath);
+  dumpPath = NULL;
+  if(!pattern) return true;
+#ifdef SSD1306_CAPTURE_FILES
+  dumpPath = (char *)malloc(strlen(pattern) + 1);
+  if(!dumpPath) return false;
+  strcpy(dumpPath, pattern);
+  return true;
+#else
+  return false;
+#endif
+}
+
+#ifdef SSD1306_CAPTURE_FILES
+
+#define ROW_BYTES ((SSD1306_LCDWIDTH + 7) / 8)
+
+// Frame as rows of pixels, MSB leftmost, lit = 1
+static void frameRows(const uint8_t *frame, uint8_t *rows) {
+  GFXcanvasPage::toRowMajor(frame, rows, SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT);
+}
+
+boolean Adafruit_SSD1306_Capture::writePBM(const char *path,
+  uint16_t back) const {
+  uint32_t       us;
+  const uint8_t *f = getFrame(back, &us);
+  if(!f) return false;
+
+  uint8_t rows[ROW_BYTES * SSD1306_LCDHEIGHT];
+  frameRows(f, rows);
+  for(uint16_t i=0; i<sizeof rows; i++) rows[i] = ~rows[i]; // PBM: 1 = black
+
+  FILE *fp = fopen(path, "wb");
+  if(!fp) return false;
+  fprintf(fp, "P4\n# micros %lu\n%d %d\n", (unsigned long)us,
+    SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT);
+  boolean ok = fwrite(rows, 1, sizeof rows, fp) == sizeof rows;
+  return (fclose(fp) == 0) && ok;
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *p, uint32_t n) {
+  crc = ~crc;
+  while(n--) {
+    crc ^= *p++;
+    for(uint8_t b=0; b<8; b++) crc = (crc >> 1) ^ (0xEDB88320UL & -(crc & 1));
+  }
+  return ~crc;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static boolean pngChunk(FILE *fp, const char *type, const uint8_t *p,
+  uint32_t n) {
+  uint8_t head[8], tail[4];
+  put32(head, n);
+  memcpy(&head[4], type, 4);
+  put32(tail, crc32(crc32(0, &head[4], 4), p, n));
+  return (fwrite(head, 1, 8, fp) == 8) && (!n || (fwrite(p, 1, n, fp) == n)) &&
+         (fwrite(tail, 1, 4, fp) == 4);
+}
+
+boolean Adafruit_SSD1306_Capture::writePNG(const char *path,
+  uint16_t back) const {
+  uint32_t       us;
+  const uint8_t *f = getFrame(back, &us);
+  if(!f) return false;
+
+  // Scanlines (filter byte 0, then the row) in a zlib stream of stored
+  // deflate blocks; the whole image fits in one
+  const uint16_t raw = SSD1306_LCDHEIGHT * (1 + ROW_BYTES);
+  uint8_t rows[ROW_BYTES * SSD1306_LCDHEIGHT],
+          z[2 + 5 + raw + 4], *s = &z[7];
+  frameRows(f, rows);
+  for(uint8_t y=0; y<SSD1306_LCDHEIGHT; y++) {
+    *s++ = 0;
+    memcpy(s, &rows[y * ROW_BYTES], ROW_BYTES);
+    s += ROW_BYTES;
+  }
+  uint32_t a = 1, b = 0; // Adler-32
+  for(uint16_t i=0; i<raw; i++) {
+    a = (a + z[7 + i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  z[0] = 0x78; z[1] = 0x01;             // zlib header, no compression
+  z[2] = 1;                             // Final stored block
+  z[3] = raw & 0xFF; z[4] = raw >> 8;
+  z[5] = ~raw & 0xFF; z[6] = (~raw >> 8) & 0xFF;
+  put32(s, (b << 16) | a);
+
+  uint8_t ihdr[13];
+  put32(&ihdr[0], SSD1306_LCDWIDTH);
+  put32(&ihdr[4], SSD1306_LCDHEIGHT);
+  ihdr[8]  = 1;  // Bit depth
+  ihdr[9]  = 0;  // Grayscale: 0 black, 1 white
+  ihdr[10] = ihdr[11] = ihdr[12] = 0;
+  char text[32];
+  int  tn = snprintf(text, sizeof text, "micros%c%lu", 0, (unsigned long)us);
+
+  static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  FILE *fp = fopen(path, "wb");
+  if(!fp) return false;
+  boolean ok = (fwrite(sig, 1, 8, fp) == 8) &&
+    pngChunk(fp, "IHDR", ihdr, sizeof ihdr) &&
+    pngChunk(fp, "tEXt", (const uint8_t *)text, tn) &&
+    pngChunk(fp, "IDAT", z, sizeof z) &&
+    pngChunk(fp, "IEND", NULL, 0);
+  return (fclose(fp) == 0) && ok;
+}
+
+#else
+
+boolean Adafruit_SSD1306_Capture::writePBM(const char *path,
+  uint16_t back) const {
+  return false;
+}
+
+boolean Adafruit_SSD1306_Capture::writePNG(const char *path,
+  uint16_t back) const {
+  return false;
+}
+
+#endif // SSD1306_CAPTURE_FILES
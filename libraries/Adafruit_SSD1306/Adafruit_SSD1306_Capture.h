@@ -0,0 +1,68 @@
+#ifndef _Adafruit_SSD1306_Capture_H_
+#define _Adafruit_SSD1306_Capture_H_
+
+#include "Adafruit_SSD1306.h"
+
+// Emulated SSD1306 panel for running without one, e.g. on a build server.
+// Plug it into an Adafruit_SSD1306 in place of the bus; drawing, frame
+// buffer and display() are then the real ones, so timings and output are
+// representative, and the command and data stream is decoded into a
+// GDDRAM copy as the controller would (addressing modes and windows,
+// start line, display offset, remap, invert, on/off).  Each display()
+// captures the visible image, in the frame buffer's page layout, with a
+// micros() timestamp:
+//
+//   Adafruit_SSD1306         display(-1);
+//   Adafruit_SSD1306_Capture panel(16);     // Keep the last 16 frames
+//   display.setCapture(&panel);
+//   display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+//   panel.setDumpPath("out/frame%05lu.png"); // Optional: one file a frame
+//   ... draw, display() ...
+//   panel.writePBM("last.pbm");
+//
+// Files are PBM (P4) or PNG (1-bit grayscale, stored uncompressed), by
+// the path's extension, lit pixels white; the timestamp goes in a comment
+// or tEXt chunk.  File output needs a hosted C library (Linux, macOS,
+// Windows); elsewhere the write functions return false.  Hardware
+// scrolling is not emulated.
+
+class Adafruit_SSD1306_Capture {
+
+ public:
+  Adafruit_SSD1306_Capture(uint16_t keep = 1);
+  ~Adafruit_SSD1306_Capture(void);
+
+  // Captured frames: 0 is the newest.  NULL if not (or no longer) kept.
+  const uint8_t *getFrame(uint16_t back = 0, uint32_t *micros = NULL) const;
+  uint32_t       getFrameCount(void) const;
+  const uint8_t *getGDDRAM(void) const;       // 8 pages of 128 bytes
+  uint32_t       getCommandBytes(void) const; // Bus traffic so far
+  uint32_t       getDataBytes(void) const;
+
+  boolean setDumpPath(const char *pattern);   // printf pattern, frame no.
+  boolean writePBM(const char *path, uint16_t back = 0) const;
+  boolean writePNG(const char *path, uint16_t back = 0) const;
+
+  // Bus side, called by Adafruit_SSD1306
+  void command(uint8_t c);
+  void data(const uint8_t *p, uint16_t n);
+  void frame(void);
+
+ private:
+  void render(uint8_t *dst) const;
+
+  uint8_t   ram[8 * 128];
+  uint8_t  *frames;           // 'keep' frames, ring
+  uint32_t *stamps;
+  uint16_t  keep;
+  uint32_t  frameCount, commandBytes, dataBytes;
+  char     *dumpPath;
+
+  uint8_t   args[7], nArgs, wantArgs; // Command being collected
+  uint8_t   col, colStart, colEnd,
+            page, pageStart, pageEnd,
+            memoryMode, startLine, offset, mux;
+  boolean   segRemap, comScanDec, inverted, allOn, on;
+};
+
+#endif /* _Adafruit_SSD1306_Capture_H_ */
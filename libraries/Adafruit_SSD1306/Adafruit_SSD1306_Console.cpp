@@ -0,0 +1,104 @@
+/*********************************************************************
+Scrolling text console for SSD1306 OLEDs, using the display start line
+register so that a new line costs one page of data instead of a frame.
+*********************************************************************/
+
+#include "Adafruit_SSD1306_Console.h"
+
+#define CONSOLE_ROWS (SSD1306_LCDHEIGHT / 8) // Text lines on screen
+#define CHAR_W       6                       // Classic font cell width
+
+Adafruit_SSD1306_Console::Adafruit_SSD1306_Console(Adafruit_SSD1306 &d) :
+  display(d), line(SSD1306_LCDWIDTH, 8) {
+  startLine = row = col = 0;
+  dirty0 = 1; dirty1 = 0;
+  pendingNewLine = false;
+}
+
+// Take over the panel and clear it.  Returns false if the line buffer
+// couldn't be allocated.
+boolean Adafruit_SSD1306_Console::begin(void) {
+  if(!line.getBuffer()) return false;
+  clear();
+  return true;
+}
+
+// Hand the panel back to display()
+void Adafruit_SSD1306_Console::end(void) {
+  display.setStartLine(0);
+}
+
+void Adafruit_SSD1306_Console::clear(void) {
+  if(!line.getBuffer()) return;
+  line.fillScreen(0);
+  startLine = row = col = 0;
+  dirty0 = 1; dirty1 = 0;
+  pendingNewLine = false;
+  display.setStartLine(0);
+  // Only the visible pages: the rest of GDDRAM is rewritten in full as
+  // scrolling exposes it
+  for(uint8_t p=0; p<CONSOLE_ROWS; p++)
+    display.sendPages(0, p, SSD1306_LCDWIDTH, 1, line.getBuffer());
+}
+
+size_t Adafruit_SSD1306_Console::write(uint8_t c) {
+  if(!line.getBuffer()) return 0;
+  put(c);
+  sendLine();
+  return 1;
+}
+
+size_t Adafruit_SSD1306_Console::write(const uint8_t *buffer, size_t size) {
+  if(!line.getBuffer()) return 0;
+  for(size_t i=0; i<size; i++) put(buffer[i]);
+  sendLine();
+  return size;
+}
+
+void Adafruit_SSD1306_Console::put(uint8_t c) {
+  if(c == '\r') return;
+  if(c == '\n') {
+    if(pendingNewLine) newLine();
+    pendingNewLine = true;
+    return;
+  }
+  if(pendingNewLine) {
+    newLine();
+    pendingNewLine = false;
+  }
+  if((col + 1) * CHAR_W > SSD1306_LCDWIDTH) newLine(); // Wrap
+
+  uint8_t x = col++ * CHAR_W;
+  line.drawChar(x, 0, c, 1, 0, 1);
+  if(dirty0 > dirty1) {            // Was clean
+    dirty0 = x;
+    dirty1 = x + CHAR_W - 1;
+  } else if(x + CHAR_W - 1 > dirty1) {
+    dirty1 = x + CHAR_W - 1;
+  }
+}
+
+// Finish the current line and move to the next, scrolling once the
+// screen is full
+void Adafruit_SSD1306_Console::newLine(void) {
+  sendLine();
+  line.fillScreen(0);
+  col = 0;
+  if(row < CONSOLE_ROWS - 1) {
+    row++;             // Still blank from clear()
+  } else {
+    startLine = (startLine + 8) & 63;
+    display.setStartLine(startLine);
+    dirty0 = 0;        // The exposed page holds an old line: rewrite it
+    dirty1 = SSD1306_LCDWIDTH - 1;
+  }
+}
+
+// Send the changed columns of the current line to its page
+void Adafruit_SSD1306_Console::sendLine(void) {
+  if(dirty0 > dirty1) return;
+  uint8_t page = ((startLine >> 3) + row) & 7;
+  display.sendPages(dirty0, page, dirty1 - dirty0 + 1, 1,
+    line.getBuffer() + dirty0);
+  dirty0 = 1; dirty1 = 0;
+}
@@ -0,0 +1,52 @@
+#ifndef _Adafruit_SSD1306_Console_H_
+#define _Adafruit_SSD1306_Console_H_
+
+#include "Adafruit_SSD1306.h"
+
+// Scrolling text console (a Print) that writes the classic 6x8 font, one
+// text line per page, straight into the panel's GDDRAM.  Once the screen
+// is full a new line scrolls it up by moving the display start line, so
+// nothing already on the panel is re-sent: appending a line uploads that
+// line only (at most one page, LCDWIDTH bytes), and printing into the
+// current line uploads just the columns that changed.
+//
+//   Adafruit_SSD1306_Console console(display);
+//   console.begin();
+//   console.println("node 12: temp 21.5");
+//
+// The console owns the panel between begin() and end(): it bypasses the
+// frame buffer, so don't call display() meanwhile.  end() puts the start
+// line back, and the next display() repaints the whole frame.  The
+// console ignores setRotation().  '\n' starts a new line (lazily, so the
+// last line isn't scrolled away before there is something to show),
+// '\r' is ignored, and long lines wrap.
+
+class Adafruit_SSD1306_Console : public Print {
+
+ public:
+  Adafruit_SSD1306_Console(Adafruit_SSD1306 &display);
+
+  boolean begin(void);
+  void    end(void);
+  void    clear(void);
+
+  size_t  write(uint8_t c);
+  size_t  write(const uint8_t *buffer, size_t size);
+  using Print::write;
+
+ private:
+  void put(uint8_t c);
+  void newLine(void);
+  void sendLine(void);
+
+  Adafruit_SSD1306 &display;
+  GFXcanvasPage     line;       // Current text line, one page
+  uint8_t           startLine,  // GDDRAM row at the top of the panel
+                    row,        // Screen row (in text lines) being written
+                    col,        // Next character cell
+                    dirty0,     // Changed columns of 'line' not yet sent,
+                    dirty1;     //  dirty0 > dirty1 if none
+  boolean           pendingNewLine;
+};
+
+#endif /* _Adafruit_SSD1306_Console_H_ */
@@ -0,0 +1,156 @@
+/*********************************************************************
+Marquee ticker for SSD1306 OLEDs that lets the controller's horizontal
+scroll engine move the pixels and only streams in new text columns.
+*********************************************************************/
+
+#include <stdlib.h>
+#include "Adafruit_SSD1306_Marquee.h"
+
+#define CHAR_W   6                      // Classic font cell width
+#define PAGES    (SSD1306_LCDHEIGHT / 8)
+#define NO_GLYPH 0xFFFFFFFFUL           // 'glyphChar' before any is drawn
+
+// Band height in pages, 1 to the whole screen
+static uint8_t fitSize(uint8_t sz) {
+  return (sz < 1) ? 1 : (sz > PAGES) ? PAGES : sz;
+}
+
+Adafruit_SSD1306_Marquee::Adafruit_SSD1306_Marquee(Adafruit_SSD1306 &d,
+  uint8_t pg, uint8_t sz) : display(d),
+  glyph(CHAR_W * fitSize(sz), 8 * fitSize(sz)) {
+  size        = fitSize(sz);
+  page        = (pg > PAGES - size) ? PAGES - size : pg; // Band on screen
+  strip       = (uint8_t *)malloc(SSD1306_LCDWIDTH * size);
+  text        = NULL;
+  length      = SSD1306_LCDWIDTH;
+  head        = length - 1;
+  sinceSync   = t0 = 0;
+  columnsSent = resyncs = 0;
+  glyphChar   = NO_GLYPH;
+  running     = false;
+  // Row period is 1 + 15 + 50 DCLKs with begin()'s precharge setting, and
+  // DCLK is the typical 370 kHz oscillator undivided (datasheet figures)
+  framePeriod = 66UL * SSD1306_LCDHEIGHT * 100 / 37;
+  setInterval(2);
+}
+
+Adafruit_SSD1306_Marquee::~Adafruit_SSD1306_Marquee(void) {
+  if(strip) free(strip);
+}
+
+void Adafruit_SSD1306_Marquee::setText(const char *t) {
+  boolean was = running;
+  if(was) stop();
+  text      = t;
+  length    = (t ? (uint32_t)strlen(t) : 0) * (CHAR_W * size) +
+              SSD1306_LCDWIDTH;
+  head      = length - 1; // End of the gap: the band starts blank
+  glyphChar = NO_GLYPH;
+  if(was) start();
+}
+
+// Frames per one-column step, rounded up to one the controller offers
+void Adafruit_SSD1306_Marquee::setInterval(uint16_t frames) {
+  static const uint16_t steps[] = {   2, 3, 4, 5, 25, 64, 128, 256 };
+  static const uint8_t  codes[] = {   7, 4, 5, 0,  6,  1,   2,   3 };
+  boolean was = running;
+  if(was) stop();
+  uint8_t i = 0;
+  while((i < 7) && (steps[i] < frames)) i++;
+  interval     = steps[i];
+  intervalCode = codes[i];
+  if(was) start();
+}
+
+void Adafruit_SSD1306_Marquee::setFramePeriod(uint32_t us) {
+  // Up to where a step of 256 frames still fits in 32 bits
+  if(us) framePeriod = (us > 0xFFFFFFFFUL / 256) ? 0xFFFFFFFFUL / 256 : us;
+}
+
+// Rewrite the band from the model and set it scrolling.  Returns false if
+// there is no text or memory.
+boolean Adafruit_SSD1306_Marquee::start(void) {
+  if(!text || !strip || !glyph.getBuffer()) return false;
+  if(running) display.stopscroll();
+  sendColumns(SSD1306_LCDWIDTH);
+  sinceSync = 0;
+  activate();
+  running = true;
+  return true;
+}
+
+// Stop scrolling, leaving the band where it got to
+void Adafruit_SSD1306_Marquee::stop(void) {
+  if(!running) return;
+  display.stopscroll();
+  head = (head + (micros() - t0) / (framePeriod * interval)) % length;
+  sendColumns(SSD1306_LCDWIDTH);
+  running = false;
+}
+
+void Adafruit_SSD1306_Marquee::update(void) {
+  if(!running) return;
+  uint32_t k = (micros() - t0) / (framePeriod * interval);
+  if(!k) return;
+
+  // The columns that scrolled off the left came back on the right; give
+  // them the next slice of text
+  display.stopscroll();
+  head       = (head + k) % length;
+  sinceSync += k;
+  if(sinceSync >= SSD1306_LCDWIDTH) {
+    sendColumns(SSD1306_LCDWIDTH);
+    sinceSync = 0;
+  } else {
+    sendColumns(k);
+  }
+  activate();
+}
+
+uint32_t Adafruit_SSD1306_Marquee::getColumnsSent(void) const {
+  return columnsSent;
+}
+
+uint32_t Adafruit_SSD1306_Marquee::getResyncs(void) const {
+  return resyncs;
+}
+
+void Adafruit_SSD1306_Marquee::activate(void) {
+  display.ssd1306_command(SSD1306_LEFT_HORIZONTAL_SCROLL);
+  display.ssd1306_command(0X00);
+  display.ssd1306_command(page);
+  display.ssd1306_command(intervalCode);
+  display.ssd1306_command(page + size - 1);
+  display.ssd1306_command(0X00);
+  display.ssd1306_command(0XFF);
+  display.ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  t0 = micros();
+}
+
+// Page 'pg' (within the band) of column t of the looped text
+uint8_t Adafruit_SSD1306_Marquee::column(uint32_t t, uint8_t pg) {
+  const uint8_t w = CHAR_W * size;
+  if(t >= length - SSD1306_LCDWIDTH) return 0; // In the gap
+  uint32_t c = t / w;
+  if(c != glyphChar) {
+    glyph.fillScreen(0);
+    glyph.drawChar(0, 0, text[c], 1, 0, size);
+    glyphChar = c;
+  }
+  return glyph.getBuffer()[t % w + pg * w];
+}
+
+// Write the n text columns up to 'head' to the n rightmost columns
+void Adafruit_SSD1306_Marquee::sendColumns(uint8_t n) {
+  uint32_t first = (head + length - (n - 1)) % length;
+  for(uint8_t pg=0; pg<size; pg++) {
+    uint32_t t = first;
+    for(uint8_t i=0; i<n; i++) {
+      strip[pg * n + i] = column(t, pg);
+      if(++t == length) t = 0;
+    }
+  }
+  display.sendPages(SSD1306_LCDWIDTH - n, page, n, size, strip);
+  columnsSent += n;
+  if(n == SSD1306_LCDWIDTH) resyncs++;
+}
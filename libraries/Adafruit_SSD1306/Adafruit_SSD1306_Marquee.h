@@ -0,0 +1,69 @@
+#ifndef _Adafruit_SSD1306_Marquee_H_
+#define _Adafruit_SSD1306_Marquee_H_
+
+#include "Adafruit_SSD1306.h"
+
+// Ticker for text too long for the screen, moved by the panel's own
+// horizontal scroll engine.  The text (classic font, 'size' pages tall,
+// starting at 'page'; moved up if it would run off the bottom) enters
+// from the right, followed by a screen-wide gap, and loops.  The panel
+// shifts the band left by one column every 'interval' frames; update()
+// only has to write the columns that wrapped round to the right edge with
+// the next slice of text: a few command bytes and 'size' data bytes per
+// column, instead of a frame per step.
+//
+//   Adafruit_SSD1306_Marquee ticker(display, 6); // Bottom page of 128x64
+//   ticker.setText("Tomorrow: rain, 12C, wind SW 20 km/h");
+//   ticker.start();
+//   ...
+//   ticker.update(); // From loop(), at least every few scroll steps
+//
+// The controller's steps aren't visible to the host, so update() counts
+// them from elapsed time, using the frame period (an estimate from the
+// datasheet's typical oscillator; calibrate with setFramePeriod()).  The
+// panel mustn't be written while it scrolls, so each update stops the
+// scroll, writes and restarts it, and once per screen width scrolled the
+// whole band is rewritten from the model, so a wrong estimate only
+// disturbs the right edge briefly.  The text must stay valid while shown.
+// Stop the marquee before using display() and start it again afterwards.
+
+class Adafruit_SSD1306_Marquee {
+
+ public:
+  Adafruit_SSD1306_Marquee(Adafruit_SSD1306 &display, uint8_t page = 0,
+    uint8_t size = 1);
+  ~Adafruit_SSD1306_Marquee(void);
+
+  void     setText(const char *text);
+  void     setInterval(uint16_t frames);  // 2, 3, 4, 5, 25, 64, 128 or 256
+  void     setFramePeriod(uint32_t us);   // Panel refresh period
+  boolean  start(void);
+  void     stop(void);
+  void     update(void);
+
+  uint32_t getColumnsSent(void) const;    // Text columns written to the panel
+  uint32_t getResyncs(void) const;        // Full band rewrites
+
+ private:
+  void    activate(void);
+  uint8_t column(uint32_t t, uint8_t pg);
+  void    sendColumns(uint8_t n);
+
+  Adafruit_SSD1306 &display;
+  GFXcanvasPage     glyph;         // Rendered character, for column reads
+  uint8_t          *strip;         // Columns being sent, page by page
+  const char       *text;
+  uint32_t          length,        // Text plus gap, in columns
+                    head,          // Text column now at the right edge
+                    sinceSync,     // Steps since the band was rewritten
+                    t0,            // micros() when the scroll (re)started
+                    framePeriod,
+                    columnsSent,
+                    resyncs,
+                    glyphChar;     // Text index of the character in 'glyph'
+  uint16_t          interval;      // Frames per step
+  uint8_t           page, size, intervalCode;
+  boolean           running;
+};
+
+#endif /* _Adafruit_SSD1306_Marquee_H_ */
@@ -0,0 +1,203 @@
+/*********************************************************************
+Shared-memory mirror of the SSD1306 frame for other processes, with a
+seqlock and per-page change tracking.  See Adafruit_SSD1306_Mirror.h.
+*********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "Adafruit_SSD1306_Mirror.h"
+
+#if defined(__linux__)
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+#define PAGES     (SSD1306_LCDHEIGHT / 8)
+#define ALL_PAGES ((1 << PAGES) - 1)
+
+Adafruit_SSD1306_Mirror::Adafruit_SSD1306_Mirror(void) {
+  seg    = NULL;
+  name   = NULL;
+  primed = false;
+}
+
+Adafruit_SSD1306_Mirror::~Adafruit_SSD1306_Mirror(void) {
+  end();
+}
+
+// Create (or reopen) the segment.  A segment left by an earlier run with
+// the same layout keeps its frame count, so readers just see new frames.
+boolean Adafruit_SSD1306_Mirror::begin(const char *n) {
+#if defined(__linux__)
+  end();
+  int fd = shm_open(n, O_CREAT | O_RDWR, 0644);
+  if(fd < 0) return false;
+  if(ftruncate(fd, sizeof(SSD1306_MirrorSegment)) < 0) {
+    close(fd);
+    return false;
+  }
+  void *p = mmap(NULL, sizeof(SSD1306_MirrorSegment),
+    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(p == MAP_FAILED) return false;
+  seg = (SSD1306_MirrorSegment *)p;
+
+  if((seg->magic != SSD1306_MIRROR_MAGIC) ||
+     (seg->version != SSD1306_MIRROR_VERSION) ||
+     (seg->width != SSD1306_LCDWIDTH) || (seg->height != SSD1306_LCDHEIGHT)) {
+    memset(seg, 0, sizeof(SSD1306_MirrorSegment));
+    seg->version = SSD1306_MIRROR_VERSION;
+    seg->width   = SSD1306_LCDWIDTH;
+    seg->height  = SSD1306_LCDHEIGHT;
+    __atomic_store_n(&seg->magic, SSD1306_MIRROR_MAGIC, __ATOMIC_RELEASE);
+  }
+  // A writer that died mid-frame leaves 'seq' odd
+  if(seg->seq & 1) __atomic_store_n(&seg->seq, seg->seq + 1, __ATOMIC_RELEASE);
+
+  name = (char *)malloc(strlen(n) + 1);
+  if(name) strcpy(name, n);
+  primed = false;
+  return true;
+#else
+  (void)n;
+  return false;
+#endif
+}
+
+void Adafruit_SSD1306_Mirror::end(boolean remove) {
+#if defined(__linux__)
+  if(seg) munmap(seg, sizeof(SSD1306_MirrorSegment));
+  if(remove && name) shm_unlink(name);
+#endif
+  seg = NULL;
+  free(name);
+  name = NULL;
+}
+
+void Adafruit_SSD1306_Mirror::publish(const uint8_t *frame, uint8_t pages) {
+  if(!seg) return;
+  if(!primed) {
+    pages  = ALL_PAGES;
+    primed = true;
+  }
+  pages &= ALL_PAGES;
+  if(!pages) return;
+
+  uint32_t s = seg->seq, f = seg->frame + 1;
+  __atomic_store_n(&seg->seq, s + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for(uint8_t p=0; p<PAGES; p++) {
+    if(pages & (1 << p)) {
+      memcpy(&seg->data[p * SSD1306_LCDWIDTH], &frame[p * SSD1306_LCDWIDTH],
+        SSD1306_LCDWIDTH);
+      seg->pageFrame[p] = f;
+    }
+  }
+  seg->dirty  = pages;
+  seg->micros = micros();
+  seg->frame  = f;
+  __atomic_store_n(&seg->seq, s + 2, __ATOMIC_RELEASE);
+}
+
+Adafruit_SSD1306_MirrorReader::Adafruit_SSD1306_MirrorReader(void) {
+  seg = NULL;
+}
+
+Adafruit_SSD1306_MirrorReader::~Adafruit_SSD1306_MirrorReader(void) {
+  end();
+}
+
+// Map an existing segment read-only.  Fails if it isn't there yet or has
+// another layout (panel size or version).
+boolean Adafruit_SSD1306_MirrorReader::begin(const char *n) {
+#if defined(__linux__)
+  end();
+  int fd = shm_open(n, O_RDONLY, 0);
+  if(fd < 0) return false;
+  struct stat st;
+  if((fstat(fd, &st) < 0) ||
+     ((size_t)st.st_size < sizeof(SSD1306_MirrorSegment))) {
+    close(fd);
+    return false;
+  }
+  void *p = mmap(NULL, sizeof(SSD1306_MirrorSegment), PROT_READ,
+    MAP_SHARED, fd, 0);
+  close(fd);
+  if(p == MAP_FAILED) return false;
+  seg = (const SSD1306_MirrorSegment *)p;
+
+  if((__atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE) != SSD1306_MIRROR_MAGIC) ||
+     (seg->version != SSD1306_MIRROR_VERSION) ||
+     (seg->width != SSD1306_LCDWIDTH) || (seg->height != SSD1306_LCDHEIGHT)) {
+    end();
+    return false;
+  }
+  return true;
+#else
+  (void)n;
+  return false;
+#endif
+}
+
+void Adafruit_SSD1306_MirrorReader::end(void) {
+#if defined(__linux__)
+  if(seg) munmap((void *)seg, sizeof(SSD1306_MirrorSegment));
+#endif
+  seg = NULL;
+}
+
+const SSD1306_MirrorSegment *Adafruit_SSD1306_MirrorReader::getSegment(void)
+  const {
+  return seg;
+}
+
+uint32_t Adafruit_SSD1306_MirrorReader::beginRead(void) const {
+  uint32_t s;
+  while((s = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE)) & 1) {
+#if defined(__linux__)
+    usleep(50); // Frame being written; it's a memcpy or two away
+#endif
+  }
+  return s;
+}
+
+boolean Adafruit_SSD1306_MirrorReader::retryRead(uint32_t s) const {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&seg->seq, __ATOMIC_RELAXED) != s;
+}
+
+boolean Adafruit_SSD1306_MirrorReader::read(uint8_t *dst, uint32_t *frame)
+  const {
+  if(!seg) return false;
+  uint32_t s, f;
+  do {
+    s = beginRead();
+    memcpy(dst, (const void *)seg->data, sizeof seg->data);
+    f = seg->frame;
+  } while(retryRead(s));
+  if(frame) *frame = f;
+  return true;
+}
+
+uint8_t Adafruit_SSD1306_MirrorReader::readChanged(uint8_t *dst,
+  uint32_t &since) const {
+  if(!seg) return 0;
+  uint32_t s, f;
+  uint8_t  pages;
+  do {
+    s     = beginRead();
+    pages = 0;
+    for(uint8_t p=0; p<PAGES; p++) {
+      if((int32_t)(seg->pageFrame[p] - since) > 0) {
+        memcpy(&dst[p * SSD1306_LCDWIDTH], &seg->data[p * SSD1306_LCDWIDTH],
+          SSD1306_LCDWIDTH);
+        pages |= 1 << p;
+      }
+    }
+    f = seg->frame;
+  } while(retryRead(s));
+  since = f;
+  return pages;
+}
@@ -0,0 +1,88 @@
+#ifndef _Adafruit_SSD1306_Mirror_H_
+#define _Adafruit_SSD1306_Mirror_H_
+
+#include "Adafruit_SSD1306.h"
+
+// Publishes what display() sends to the panel into a POSIX shared-memory
+// segment, so other processes (a web dashboard, a screenshot tool) can see
+// the screen without touching the bus.  Linux only (link with -lrt on
+// glibc before 2.17); elsewhere begin() returns false and nothing is
+// published.
+//
+//   Adafruit_SSD1306_Mirror mirror;
+//   mirror.begin("/ssd1306");
+//   display.setMirror(&mirror);
+//
+// The segment is an SSD1306_MirrorSegment.  Writes are guarded by a
+// sequence counter (seqlock): 'seq' is odd while a frame is being written
+// and moves on by two per frame, so a reader that sees the same even
+// value before and after reading had a consistent frame.  Only pages that
+// changed are rewritten; 'pageFrame' tells which frame last changed each
+// page, so a reader can copy only what is new since it last looked.
+// Adafruit_SSD1306_MirrorReader does all this for C++ readers; the layout
+// is plain little-endian fields for anyone else.  Widgets that write
+// GDDRAM directly (console, marquee) are not mirrored.
+
+#define SSD1306_MIRROR_MAGIC   0x31445353UL // "SSD1"
+#define SSD1306_MIRROR_VERSION 1
+
+typedef struct {
+  uint32_t magic, version;
+  uint16_t width, height; // Pixels; data is height/8 pages of width bytes
+  uint32_t seq;           // Seqlock: odd while a frame is being written
+  uint32_t frame;         // Frames published
+  uint32_t dirty;         // Bit p set: page p changed in the latest frame
+  uint32_t pageFrame[8];  // Frame in which each page last changed
+  uint32_t micros;        // micros() when the latest frame was published
+  uint8_t  data[SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8]; // Frame buffer
+} SSD1306_MirrorSegment;   //  layout: vertical bytes, LSB on top
+
+class Adafruit_SSD1306_Mirror {
+
+ public:
+  Adafruit_SSD1306_Mirror(void);
+  ~Adafruit_SSD1306_Mirror(void);
+
+  boolean begin(const char *name = "/ssd1306");
+  void    end(boolean remove = false); // Optionally shm_unlink() it too
+
+  // Called by Adafruit_SSD1306::display(), bit p of 'pages' set for each
+  // page that changed
+  void    publish(const uint8_t *frame, uint8_t pages);
+
+ private:
+  SSD1306_MirrorSegment *seg;
+  char                  *name;
+  boolean                primed; // Whole frame published since begin()
+};
+
+class Adafruit_SSD1306_MirrorReader {
+
+ public:
+  Adafruit_SSD1306_MirrorReader(void);
+  ~Adafruit_SSD1306_MirrorReader(void);
+
+  boolean begin(const char *name = "/ssd1306");
+  void    end(void);
+
+  // Zero-copy access: read the segment in place between beginRead() and
+  // retryRead(), and start over while retryRead() returns true
+  //
+  //   do { s = reader.beginRead(); ...use seg->data... }
+  //   while(reader.retryRead(s));
+  const SSD1306_MirrorSegment *getSegment(void) const;
+  uint32_t beginRead(void) const;
+  boolean  retryRead(uint32_t seq) const;
+
+  // Copy the whole frame; returns its number in *frame
+  boolean  read(uint8_t *dst, uint32_t *frame = NULL) const;
+  // Copy only pages changed after frame 'since' into dst (frame buffer
+  // layout) and set 'since' to the frame copied.  Returns the pages copied
+  // as a bit mask.
+  uint8_t  readChanged(uint8_t *dst, uint32_t &since) const;
+
+ private:
+  const SSD1306_MirrorSegment *seg;
+};
+
+#endif /* _Adafruit_SSD1306_Mirror_H_ */